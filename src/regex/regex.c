@@ -4,11 +4,25 @@
  * regex.h . Specifically, this file will generate a state machine that recognizes
  * strings belonging to a regular expression
  */ 
+//We need this for memmem
+#define _GNU_SOURCE
 #include "regex.h" 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+//The vectorized start byte search uses whatever the compiler gives us
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 //Forward declare
 typedef struct NFA_state_t NFA_state_t;
@@ -18,6 +32,10 @@ typedef struct state_list_t state_list_t ;
 typedef struct NFA_state_list_t NFA_state_list_t;
 typedef struct DFA_state_t DFA_state_t;
 
+//Cleanup is at the very bottom, but the builders need it too
+static void teardown_NFA(NFA_state_t* state_ptr);
+static void teardown_DFA(DFA_state_t* state);
+
 
 /**
  * A struct that defines an NFA state
@@ -33,6 +51,11 @@ struct NFA_state_t {
 	u_int8_t visited;
 	//The char that we hold
 	u_int16_t opt;
+	//The number of this state. Every state in an NFA(or group of NFAs) has a unique id, which is
+	//used by the subset construction
+	u_int32_t id;
+	//For accepting states, which pattern in a regex set this state accepts
+	u_int32_t pattern_id;
 	//The default next 
 	NFA_state_t* next;
 	//The optional second next for alternating states 
@@ -75,11 +98,14 @@ struct NFA_fragement_t {
  * NFA states. This struct will be used for this purpose
  */
 struct NFA_state_list_t {
-	NFA_state_t* states[145];
+	//This list is dynamically allocated to be exactly as big as it needs to be
+	NFA_state_t** states;
 	//Length of our list
-	u_int16_t length;
+	u_int32_t length;
 	//Does this list contain an accepting state?
 	u_int8_t contains_accepting_state;
+	//For leftmost-longest DFAs, has a match been seen yet? Once it has, no new matches are started
+	u_int8_t seen_match;
 	//Does this list have a wildcard?
 	u_int8_t contains_wild_card;
 	//Does this list have a NUMBERS state?
@@ -100,19 +126,190 @@ struct NFA_state_list_t {
 struct DFA_state_t {
 	//The list of the NFA states that make up the DFA state
 	NFA_state_list_t nfa_state_list;
-	//Hold the address of the NFA state
-	NFA_state_t* nfa_state;
-	//This list is a list of all the states that come from this DFA state. We will use the char itself to index this state. Remember that printable
-	//chars range from 0-127
-	DFA_state_t* transitions[135];
+	//Where we go on every possible byte, indexed by the byte itself. Bytes that can't be matched still get a column, so
+	//that walking the DFA never needs to check what it's looking at. States in a lazy DFA don't have these, since their
+	//transitions only ever live in the transition table
+	DFA_state_t** transitions;
 	//The next dfa_state that was made, this will help us in freeing
 	DFA_state_t* next;
+	//The next state in the same hash bucket. Only used by the subset construction
+	DFA_state_t* hash_next;
+	//Every state in a DFA gets a unique id, in the order that they were made
+	u_int32_t id;
+	//For regex sets, every pattern that is accepted by this state
+	u_int32_t* accepted_patterns;
+	//How many patterns are accepted here
+	u_int32_t num_accepted_patterns;
 };
 
+
+/**
+ * All of the bookkeeping that the subset construction needs. DFA states are made up of sets of
+ * NFA states, and we need to be able to quickly find out if we've seen a given set before
+ */
+typedef struct {
+	//Every DFA state made so far, chained together through "next"
+	DFA_state_t* head;
+	DFA_state_t* tail;
+	//How many DFA states we've made
+	u_int32_t num_dfa_states;
+	//A hash table of every DFA state, keyed on its NFA state list
+	DFA_state_t* buckets[SUBSET_HASH_BUCKETS];
+	//The NFA states that we start from, one per pattern
+	NFA_state_t** starts;
+	u_int32_t num_starts;
+	//Unanchored DFAs only add the first num_restarts starts back into every closure. The rest belong to patterns that start
+	//with ^, so they're only in the start state
+	u_int32_t num_restarts;
+	//How many NFA states there are in total
+	u_int32_t num_nfa_states;
+	//If this is set, every DFA state also contains the start states. This is what makes the
+	//DFA search for a match anywhere in the input instead of only at the start
+	u_int8_t unanchored;
+	//If this is set, the DFA finds the end of the leftmost-longest match. The NFA states in every DFA state are split up into
+	//groups by where their match started(separated by NULLs, earliest first), and once a group accepts, every group that started
+	//after it is thrown away and no new groups are started
+	u_int8_t leftmost;
+	//If this is set, the DFA reads the input backwards to find where matches start. See reverse_step
+	u_int8_t reverse;
+	//If this is set, states are made one at a time as the match functions need them, and they don't get their own transitions
+	u_int8_t lazy;
+	//The most states that we'll make before giving up(or flushing, for lazy DFAs)
+	u_int32_t max_states;
+	//Scratch space for computing closures, all sized to num_nfa_states
+	u_int32_t* marks;
+	u_int32_t generation;
+	NFA_state_t** dfs_stack;
+	NFA_state_list_t scratch;
+	//A second scratch list, so that a lazy DFA can hold on to one set while it makes another
+	NFA_state_t** spare;
+	//For reverse DFAs, every NFA state that consumes a character, along with the ids of everything in the closure right after it
+	NFA_state_t** consuming;
+	u_int32_t** closures;
+	u_int32_t* closure_lengths;
+	u_int32_t num_consuming;
+	//For reverse DFAs, the ids of everything in the closure of the start state, and the state that we start reading backwards from
+	u_int32_t* start_closure;
+	u_int32_t start_closure_length;
+	NFA_state_t* accepting_state;
+} subset_builder_t;
+
+
+/**
+ * The three DFAs that every regex has
+ */
+typedef enum {
+	//Used for ^ and full matches, and to find the start set
+	DFA_ANCHORED,
+	//Finds where matches end
+	DFA_FORWARD,
+	//Finds where matches start
+	DFA_REVERSE,
+} DFA_kind_t;
+
+
+/**
+ * A DFA flattened into one table of packed transitions. Every state gets a row of 256 entries, and we know a state by
+ * where its row starts(its id * 256). Each entry is the row of the state that we go to, with flags in the high bits
+ * saying if that state is dead, accepting, or the start state that we can skip ahead from. Nearly every byte leads to a
+ * state with no flags, so walking the table is one load and one check per byte, and everything else is off to the side.
+ * Every matcher walks a table, regex sets included. The states themselves are only looked at for what a packed entry can't
+ * hold, like which patterns a set's accepting state matched.
+ *
+ * A lazy table starts out with nothing but the start state, and every entry that we haven't needed yet is TRANSITION_UNKNOWN.
+ * The first time that one is taken, its builder works out where it goes. Once the table has LAZY_DFA_MAX_STATES states,
+ * everything is thrown out and we start over from the start state, so a lazy table never gets any bigger than that
+ */
+typedef struct {
+	//num_states rows of 256 packed transitions
+	u_int32_t* transitions;
+	//Every state in the table, by id
+	DFA_state_t** states;
+	u_int32_t num_states;
+	//How many states we have room for
+	u_int32_t capacity;
+	//If this is set, every transition into the start state(which is always row 0) gets TRANSITION_START
+	u_int8_t skip_start;
+	//For lazy tables, the builder that makes new states. This is NULL if every state was made up front
+	subset_builder_t* builder;
+	//How many times a lazy table has been flushed. Any packed state from before a flush is no good afterwards
+	u_int32_t generation;
+	//How many bytes have been searched with a lazy table, so that we can tell if it's flushed too often to be of any use
+	size_t bytes_searched;
+} transition_table_t;
+
+
+/**
+ * The set of bytes that can start a match, along with everything that we need to search for
+ * them quickly. This is built from the transitions out of the DFA's start state
+ */
+typedef struct {
+	//member[ch] is 1 if ch can start a match
+	u_int8_t member[256];
+	//Every byte in the set as a null terminated string, which is what strcspn wants
+	char bytes[129];
+	//How many bytes are in the set
+	u_int8_t num_bytes;
+	//The set broken up into contiguous ranges for the vectorized search. If there are more
+	//than START_SET_MAX_RANGES ranges, num_ranges is 0 and we won't vectorize
+	u_int8_t range_low[START_SET_MAX_RANGES];
+	u_int8_t range_high[START_SET_MAX_RANGES];
+	u_int8_t num_ranges;
+} start_set_t;
+
+
+/**
+ * A small set of literal strings. This is used by the required factor analysis to describe either every string that
+ * a piece of the regex can match, or a set of strings that at least one of has to show up in anything it matches
+ */
+typedef struct {
+	//The strings themselves. These are null terminated so that they can be printed
+	char strings[REQUIRED_FACTOR_MAX_ALTERNATIVES][REQUIRED_FACTOR_MAX_LENGTH + 1];
+	u_int8_t lengths[REQUIRED_FACTOR_MAX_ALTERNATIVES];
+	//How many strings there are
+	u_int8_t count;
+	//If this is 0, we don't know anything and the strings mean nothing
+	u_int8_t valid;
+} factor_set_t;
+
+
+/**
+ * What the required factor analysis knows about one piece of the regex
+ */
+typedef struct {
+	//If valid, this is exactly every string that this piece can match
+	factor_set_t exact;
+	//If valid, everything that this piece matches starts with one of these
+	factor_set_t prefix;
+	//If valid, everything that this piece matches ends with one of these
+	factor_set_t suffix;
+	//If valid, everything that this piece matches contains at least one of these
+	factor_set_t required;
+} factor_info_t;
+
+
+/**
+ * The literal factors that every match has to contain at least one of, along with a Horspool shift table
+ * so that we can look for all of them in one pass
+ */
+typedef struct {
+	//The factors themselves
+	char* factors[REQUIRED_FACTOR_MAX_ALTERNATIVES];
+	u_int32_t lengths[REQUIRED_FACTOR_MAX_ALTERNATIVES];
+	u_int32_t num_factors;
+	//The length of the shortest factor. The search window is this wide
+	u_int32_t min_length;
+	//How far we can slide the window when we see a given byte at its very end
+	u_int32_t shift[256];
+} required_factors_t;
+
+
 /**
- * An improved version of the postfix converter using an operator stack
+ * An improved version of the postfix converter using an operator stack. If capture_groups is set, the end of every
+ * parenthesized group is marked with CAPTURE_GROUP followed by the group's number plus one, so that the captures
+ * can be built from it. The first REGEX_MAX_GROUPS groups are numbered in the order that they're opened
  */
-char* in_to_post(char* regex, regex_mode_t mode){
+char* in_to_post(char* regex, u_int8_t capture_groups, regex_mode_t mode){
 	//Sanity check
 	if(regex == NULL || strlen(regex) == 0){
 		if(mode == REGEX_VERBOSE){
@@ -340,6 +537,10 @@ char* in_to_post(char* regex, regex_mode_t mode){
 	char* postfix_cursor = postfix;
 	char stack_cursor;
 	u_int8_t found_open;
+	//The number of every group that is still open, innermost last
+	u_int32_t open_groups[REGEX_LEN];
+	u_int32_t num_open_groups = 0;
+	u_int32_t num_groups = 0;
 
 	//An operator stack that will hold any operators that we see
 	stack_t* operator_stack = create_stack();
@@ -497,6 +698,11 @@ char* in_to_post(char* regex, regex_mode_t mode){
 			case '(':
 				//If we see this, we simply push it onto the stack and keep moving
 				push(operator_stack, "(");
+
+				//Groups are numbered by where they open
+				open_groups[num_open_groups] = num_groups;
+				num_open_groups++;
+				num_groups++;
 				//Move on to next character
 				concat_cursor++;
 
@@ -534,6 +740,16 @@ char* in_to_post(char* regex, regex_mode_t mode){
 					destroy_stack(operator_stack, STATES_ONLY);
 					return NULL;
 				}
+
+				num_open_groups--;
+
+				//Everything in the group is in the postfix now, so this is where it ends
+				if(capture_groups == 1 && open_groups[num_open_groups] < REGEX_MAX_GROUPS){
+					*postfix_cursor = CAPTURE_GROUP;
+					postfix_cursor++;
+					*postfix_cursor = open_groups[num_open_groups] + 1;
+					postfix_cursor++;
+				}
 				
 				//Advance the cursor
 				concat_cursor++;
@@ -736,6 +952,8 @@ static void print_NFA(NFA_state_t* nfa){
 		printf("State -SPLIT_KLEENE->");
 	} else if(nfa->opt == ACCEPTING){
 		printf("State -ACCEPTING->");
+	} else if(nfa->opt >= FOLDED_LETTER && nfa->opt < FOLDED_LETTER + 26){
+		printf("State -%c/%c->", 'a' + (nfa->opt - FOLDED_LETTER), 'A' + (nfa->opt - FOLDED_LETTER));
 	} else {
 		printf("State -%c->", (u_int8_t)nfa->opt);
 	}
@@ -769,7 +987,7 @@ static void create_NFA(regex_t* regex, char* postfix, regex_mode_t mode){
 	NFA_fragement_t* frag_1;
 	NFA_fragement_t* fragment;
 	NFA_state_t* split;
-	NFA_state_t* s;
+	NFA_state_t* s = NULL;
 
 	//Declare this for our use as well
 	fringe_states_t* fringe;
@@ -932,6 +1150,32 @@ static void create_NFA(regex_t* regex, char* postfix, regex_mode_t mode){
 
 				break;
 
+			//The end of a capture group. The group gets a state on either side of it that saves where it starts and ends
+			case CAPTURE_GROUP:
+				cursor++;
+
+				//The group that we're capturing
+				frag_1 = pop(stack);
+
+				//The next character is the group's number plus one, and every group has two slots
+				s = create_state(SAVE_SLOT + 2 * (*cursor - 1), frag_1->start, NULL);
+				split = create_state(SAVE_SLOT + 2 * (*cursor - 1) + 1, NULL, NULL);
+
+				//Linked list attachment
+				s->next_created = head;
+				split->next_created = s;
+				head = split;
+
+				//Everything that the group ends on goes to the closing save
+				concatenate_states(frag_1->fringe_states, split, 1);
+				destroy_fringe_list(frag_1->fringe_states);
+
+				push(stack, create_fragment(s, init_list(split)));
+
+				free(frag_1);
+
+				break;
+
 			//If we see the escape character, then we process the immediately next character as a regular char
 			case '\\':
 				cursor++;
@@ -1084,47 +1328,28 @@ static void create_NFA(regex_t* regex, char* postfix, regex_mode_t mode){
 	regex->NFA = starting_state;
 }
 
-/* ================================================ End NFA Methods ================================================ */
-
-
-/* ================================================== DFA Methods ================================================== */
 
 /**
- * For debugging only
+ * Fold the case of every letter in the NFA for REGEX_ICASE. Plain letters become FOLDED_LETTER states that match either case,
+ * and the a-z and A-Z ranges both become a-zA-Z. Everything that's built from the NFA afterwards(the DFAs, the Pike VM and the
+ * position automaton) asks the states which bytes they take, so none of them need to know about this
  */
-static void print_state(DFA_state_t* state){
-	if(state == NULL){
-		printf("NULL STATE\n");
-	}
-
-	printf("INSIDE: {");
-	//Print out what the state has in it
-	for(u_int16_t i = 0; i < state->nfa_state_list.length; i++){
-		u_int16_t opt = state->nfa_state_list.states[i]->opt;
-		if(opt >= 32 && opt <= 127){
-			printf("%c, ", opt);
-		} else if(opt==ACCEPTING){
-			printf("ACCEPTING\n");
+static void fold_NFA_case(NFA_state_t* creation_chain){
+	for(NFA_state_t* cursor = creation_chain; cursor != NULL; cursor = cursor->next_created){
+		if(cursor->opt >= 'a' && cursor->opt <= 'z'){
+			cursor->opt = FOLDED_LETTER + (cursor->opt - 'a');
+		} else if(cursor->opt >= 'A' && cursor->opt <= 'Z'){
+			cursor->opt = FOLDED_LETTER + (cursor->opt - 'A');
+		} else if(cursor->opt == LOWERCASE || cursor->opt == UPPERCASE){
+			cursor->opt = LETTERS;
 		}
 	}
-	
-	printf(" } -> ");
+}
 
-	printf("REACHABLE: {");
-	for(u_int16_t i = 0; i < 135; i++){
-		if(state->transitions[i] != NULL){
-			if(i >= 32 && i <= 127){
-				printf("%c, ", i);
-			} else if (i == ACCEPTING){
-				printf("ACCEPTING, ");
-			}
+/* ================================================ End NFA Methods ================================================ */
 
-		} 	
-	}
 
-	
-	printf("} NFA: %p\n", state->nfa_state);
-}
+/* ================================================== DFA Methods ================================================== */
 
 /**
  * Follow all of the arrows that we have and recursively build a DFA state that is itself
@@ -1159,691 +1384,4774 @@ static void get_reachable_rec(NFA_state_t* start, NFA_state_list_t* list){
 
 
 /**
- * Initialize a DFA state list by reading all of the transitions of states reachable directly from "start". This new
- * list will be stored in "list". "num_states" is the number of DFA states, which should in theory be the maximum number of 
- * states we could possibly have in one of our DFA state lists
+ * Give every state in the creation chain a unique id, starting at "first_id". Returns the
+ * id that the next state should get
  */
-static void get_all_reachable_states(NFA_state_t* start, NFA_state_list_t* state_list){
-	//Currently there's nothing, so we'll set this to 0
-	state_list->length = 0;
+static u_int32_t number_NFA_states(NFA_state_t* creation_chain, u_int32_t first_id){
+	//Walk the whole chain
+	for(NFA_state_t* cursor = creation_chain; cursor != NULL; cursor = cursor->next_created){
+		cursor->id = first_id;
+		first_id++;
+	}
+
+	return first_id;
+}
 
-	//By default, we don't have an accepting state in our list
-	state_list->contains_accepting_state = 0;
 
-	//Begin our conversion by converting the start state given here into a DFA state
-	get_reachable_rec(start, state_list);
+/**
+ * Is this NFA state a split state? Split states never consume anything, they just
+ * give us two places to go
+ */
+static u_int8_t is_split_state(NFA_state_t* state){
+	return state->opt >= SPLIT_ZERO_OR_ONE && state->opt <= SPLIT_POSITIVE_CLOSURE;
 }
 
 
 /**
- * A constructor that returns a DFA state whose "internals" are the list of NFA states
- * that are reachable at this state. This DFA state is dynamically allocated, and as such will need
- * to be destroyed at some point
+ * Does an NFA state with this opt consume the character "ch"? The Pike VM only keeps the opts around, so this
+ * is shared between it and the subset construction
  */
-static DFA_state_t* create_DFA_state(NFA_state_t* nfa_state, DFA_state_t** chain, u_int16_t* next_idx){
-	//Allocate a DFA state
-	DFA_state_t* dfa_state = (DFA_state_t*)calloc(1, sizeof(DFA_state_t));
-	dfa_state->nfa_state = nfa_state;
-	//Add this in
-	chain[*next_idx] = dfa_state;
-	//Increment
-	(*next_idx)++;
+static u_int8_t opt_accepts_char(u_int16_t opt, u_int8_t ch){
+	//Nothing above 127 can ever be matched. This also keeps those bytes from being mistaken for one of the special opts
+	if(ch > 127){
+		return 0;
+	}
 
-	//Set to null as warning
-	dfa_state->next = NULL;
+	switch(opt){
+		//Any printable character
+		case WILDCARD:
+			return ch >= 32 && ch <= 126;
+		//[0-9]
+		case NUMBER:
+			return ch >= '0' && ch <= '9';
+		//[a-z]
+		case LOWERCASE:
+			return ch >= 'a' && ch <= 'z';
+		//[A-Z]
+		case UPPERCASE:
+			return ch >= 'A' && ch <= 'Z';
+		//[a-zA-Z]
+		case LETTERS:
+			return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+		//Otherwise we just have a regular character. Split and accepting states will never
+		//match here because they're all above 127
+		default:
+			//A letter that was folded by REGEX_ICASE matches either case. Setting 0x20 lowercases a letter and leaves
+			//no other byte in a-z
+			if(opt >= FOLDED_LETTER && opt < FOLDED_LETTER + 26){
+				return (ch | 0x20) == 'a' + (opt - FOLDED_LETTER);
+			}
 
-	//Get all of the reachable NFA states for that DFA state, this is how we handle splits
-	if(nfa_state != NULL){
-		get_all_reachable_states(nfa_state, &(dfa_state->nfa_state_list));
+			return opt == ch;
 	}
+}
 
-	//Return a pointer to our state
-	return dfa_state;
+
+/**
+ * Does this NFA state consume the character "ch"?
+ */
+static u_int8_t nfa_state_accepts_char(NFA_state_t* state, u_int8_t ch){
+	return opt_accepts_char(state->opt, ch);
 }
 
 
 /**
- * Make use of a variety of logic to properly make previous point to connecter
+ * Follow every split state reachable from "start", adding every non-split state that we find into the 
+ * builder's scratch list. The marks make sure that we add each state at most once, and they also
+ * keep us from looping forever on splits that point back to themselves
  */
-void connect_DFA_states(DFA_state_t* previous, DFA_state_t* connecter){
-	//Save ourselves here
-	if(connecter == NULL){
-		return;
+static void add_closure(subset_builder_t* builder, NFA_state_t* start){
+	u_int32_t stack_top = 0;
+	NFA_state_t* state;
+
+	//Seed the stack
+	if(start != NULL){
+		builder->dfs_stack[stack_top] = start;
+		stack_top++;
 	}
 
-	//If the state is null, we'll have to go to his transitions
-	if(connecter->nfa_state == NULL){
-		for(u_int16_t i = 0; i < 135; i++){
-			connect_DFA_states(previous, connecter->transitions[i]);
+	while(stack_top > 0){
+		//Pop off the top
+		stack_top--;
+		state = builder->dfs_stack[stack_top];
+
+		//If we've already seen this one in this closure, skip it
+		if(builder->marks[state->id] == builder->generation){
+			continue;
 		}
-	} else {
-		//This means that we'll connect everything 
-		if(connecter->nfa_state_list.contains_wild_card == 1){
-			for(u_int16_t i = 32; i < 127; i++){
-				previous->transitions[i] = connecter;
-			}
-		//If we have the '[0-9]' state
-		} else if(connecter->nfa_state_list.contains_numbers == 1){
-			for(u_int16_t i = '0'; i <= '9'; i++){
-				previous->transitions[i] = connecter;
-			}
-		//If we have the '[a-z]' state
-		} else if(connecter->nfa_state_list.contains_lowercase == 1){
-			for(u_int16_t i = 'a'; i <= 'z'; i++){
-				previous->transitions[i] = connecter;
-			}
 
-		//If we have '[A-Z]'
-		} else if(connecter->nfa_state_list.contains_uppercase == 1){
-			for(u_int16_t i = 'A'; i <= 'Z'; i++){
-				previous->transitions[i] = connecter;
-			}
+		builder->marks[state->id] = builder->generation;
 
-		//If we have '[a-zA-Z]'
-		} else if(connecter->nfa_state_list.contains_letters == 1){
-			for(u_int16_t i = 'a'; i <= 'z'; i++){
-				previous->transitions[i] = connecter;
+		//Split states are followed but never stored
+		if(is_split_state(state) == 1){
+			if(state->next != NULL){
+				builder->dfs_stack[stack_top] = state->next;
+				stack_top++;
 			}
 
-			for(u_int16_t i = 'A'; i <= 'Z'; i++){
-				previous->transitions[i] = connecter;
+			if(state->next_opt != NULL){
+				builder->dfs_stack[stack_top] = state->next_opt;
+				stack_top++;
 			}
-		//Otherwise we just have a regular state
 		} else {
-			for(u_int16_t i = 0; i < connecter->nfa_state_list.length; i++){
-				u_int16_t opt = connecter->nfa_state_list.states[i]->opt;
-				previous->transitions[opt] = connecter;		
-			}
+			//This will also set all of our flags, like contains_accepting_state
+			get_reachable_rec(state, &(builder->scratch));
 		}
-
 	}
 }
 
 
 /**
- * Check for state equality
+ * Sort NFA states by id, so that two lists holding the same states are always identical
  */
-static u_int8_t dfa_states_equal(DFA_state_t* a, DFA_state_t* b){
-	//By default not equal
-	if(a == NULL || b == NULL){
-		return 0;
+static int compare_NFA_states(const void* a, const void* b){
+	u_int32_t id_a = (*(NFA_state_t**)a)->id;
+	u_int32_t id_b = (*(NFA_state_t**)b)->id;
+
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+
+/**
+ * Sort an NFA state list. Leftmost-longest lists are made up of groups that end in NULL, and the order of the
+ * groups matters, so each group is sorted on its own
+ */
+static void sort_NFA_state_list(NFA_state_list_t* list){
+	u_int32_t group_start = 0;
+
+	for(u_int32_t i = 0; i <= list->length; i++){
+		if(i == list->length || list->states[i] == NULL){
+			qsort(list->states + group_start, i - group_start, sizeof(NFA_state_t*), compare_NFA_states);
+			group_start = i + 1;
+		}
 	}
+}
 
-	//These could be equal
-	if((a->nfa_state != NULL && b->nfa_state != NULL) &&
-		(a->nfa_state == b->nfa_state)){
-		return 1;
+
+/**
+ * Hash an NFA state list so that we can look it up in the builder's table
+ */
+static u_int32_t hash_NFA_state_list(NFA_state_list_t* list){
+	//FNV-1a over all of the ids
+	u_int32_t hash = 2166136261u;
+
+	for(u_int32_t i = 0; i < list->length; i++){
+		//The end of a group hashes differently from any state
+		hash ^= list->states[i] != NULL ? list->states[i]->id : 0xFFFFFFFFu;
+		hash *= 16777619u;
 	}
 
-	//Special case, they aren't equal because of a split
-	//Are the lengths equal?
-	if(a->nfa_state_list.length != b->nfa_state_list.length){
+	hash ^= list->seen_match;
+	hash *= 16777619u;
+
+	return hash % SUBSET_HASH_BUCKETS;
+}
+
+
+/**
+ * Check if two NFA state lists hold the exact same states
+ */
+static u_int8_t NFA_state_lists_equal(NFA_state_list_t* a, NFA_state_list_t* b){
+	//Different lengths are never equal, and neither are lists that have and haven't seen a match
+	if(a->length != b->length || a->seen_match != b->seen_match){
 		return 0;
 	}
 
-	//If they are, we'll check state by state
-	for(u_int16_t i = 0; i < a->nfa_state_list.length; i++){
-		//If these aren't equal, get out
-		if(a->nfa_state_list.states[i] != b->nfa_state_list.states[i]){
+	//Both lists are sorted, so we can go state by state
+	for(u_int32_t i = 0; i < a->length; i++){
+		if(a->states[i] != b->states[i]){
 			return 0;
 		}
 	}
-	
-	//If we get here we know its good
+
 	return 1;
 }
 
 
 /**
- * Translate an NFA into an equivalent DFA using the reachability matrix
- * method. We will recursively figure out which states are reachable from other states. Our
- * new linked list of states should help us with this
+ * Take the NFA states that are sitting in the builder's scratch list and find the DFA state that they make up. If we've
+ * never seen this set before, a new DFA state is made and put on the end of the chain so that we'll get to it later.
+ * If the set is empty, there is nowhere to go and we return NULL
  */
-static DFA_state_t* create_DFA(DFA_state_t** chain, u_int16_t* next_idx, NFA_state_t* nfa_start, regex_mode_t mode, char go_until){
-	//The starting state for our DFA
-	DFA_state_t* previous;
-	DFA_state_t* temp;
-	DFA_state_t* left_opt;
-	DFA_state_t* left_opt_mem;
-	DFA_state_t* right_opt;
-	DFA_state_t* right_opt_mem;
+static DFA_state_t* find_or_create_subset_state(subset_builder_t* builder){
+	NFA_state_list_t* scratch = &(builder->scratch);
 
-	//The cursor that we may or may not use
-	DFA_state_t* cursor;
-
-	//A dummy start state to enter into
-	DFA_state_t* dfa_start = create_DFA_state(NULL, chain, next_idx);
+	//Nothing here means no transition
+	if(scratch->length == 0){
+		return NULL;
+	}
 
-	//dfa_start->nfa_state = nfa_start;
-	previous = dfa_start;
+	//Sort so that the same set always looks the same
+	sort_NFA_state_list(scratch);
 
-	//Maintain a cursor to the current NFA state
-	NFA_state_t* nfa_cursor = nfa_start;
+	//Have we seen this one before?
+	u_int32_t bucket = hash_NFA_state_list(scratch);
+	for(DFA_state_t* cursor = builder->buckets[bucket]; cursor != NULL; cursor = cursor->hash_next){
+		if(NFA_state_lists_equal(&(cursor->nfa_state_list), scratch) == 1){
+			return cursor;
+		}
+	}
 
-	//Iterate through every NFA state. We have a 1-1 nfa-state dfa-state translation
-	while(nfa_cursor != NULL){
-		//Reset these here
-		left_opt_mem = NULL;
-		right_opt_mem = NULL;
+	//If we've hit the limit, we're done
+	if(builder->num_dfa_states >= builder->max_states){
+		return NULL;
+	}
 
-		//If we've gotten where we need to go
-		if(nfa_cursor->opt == go_until){
-			return dfa_start;
-		}
+	//We haven't, so we'll need a new state
+	DFA_state_t* dfa_state = calloc(1, sizeof(DFA_state_t));
+	dfa_state->id = builder->num_dfa_states;
 
-		//If we've already gotten to this guy from a split, we'll move right on
-		if(nfa_cursor->visited == 1){
-			nfa_cursor = nfa_cursor->next;
-			continue;
-		}
+	//Lazy states only have their transitions in the table
+	if(builder->lazy == 0){
+		dfa_state->transitions = calloc(256, sizeof(DFA_state_t*));
+	}
 
-		//We have different processing rules for each of our special cases. The default is of course that we just have a char
-		switch(nfa_cursor->opt){
-			case SPLIT_ZERO_OR_ONE:
-				nfa_cursor->visited = 1;
-				//Create the DFA for the straight path, marking each state as "off limits" whenever we see it.
-				//This marking of off limits will ensure that the next function call will not retrace this
-				//one's steps
-				//Create the right sub-DFA that is the optional "0 or 1" DFA
-				right_opt = create_DFA(chain, next_idx, nfa_cursor->next_opt, mode, nfa_cursor->next->opt);
-
-				left_opt = create_DFA(chain, next_idx, nfa_cursor->next, mode, '\0');
-				//Save these for later for memory deletion
-				left_opt_mem = left_opt;
-				right_opt_mem = right_opt;
-
-				/**
-				 * We now have
-				 * 	The "previous" state, which is what came before the DFA
-				 * 	Left_opt: the entire DFA that follows the nonoptional path
-				 * 	Right_opt: the entire optional path that represents our "0 or 1"
-				 *
-				 * 	We'll now do 2 things:
-				 * 		Patch in "previous" to point to both left_opt and right_opt
-				 * 		patch in the end of right_opt to point to left_opt
-				 */
-
-				//Connect previous to right_opt
-				connect_DFA_states(previous, right_opt);
-			
-				//Connect previous to left_opt
-				connect_DFA_states(previous, left_opt);
-	
-				//Now we'll need to ensure that right_opt(At the very end) points to left_opt
-				//Let's first advance to the very end of right_opt
-				cursor = right_opt;
-				//Advance to very end
-				while(cursor->next != NULL){
-					cursor = cursor->next;
-				}
+	//Copy over the list and all of its flags
+	dfa_state->nfa_state_list = *scratch;
+	dfa_state->nfa_state_list.states = malloc(scratch->length * sizeof(NFA_state_t*));
+	memcpy(dfa_state->nfa_state_list.states, scratch->states, scratch->length * sizeof(NFA_state_t*));
 
-				//Connect the cursor to left_opt
-				connect_DFA_states(cursor, left_opt);
+	//Record every pattern that this state accepts
+	if(scratch->contains_accepting_state == 1){
+		dfa_state->accepted_patterns = malloc(scratch->length * sizeof(u_int32_t));
 
-				//We need to chain all of these together for the eventual memory freeing
-				previous->next = left_opt_mem;
-				previous = left_opt_mem;
-				while(previous->next != NULL){
-					previous = previous->next;
-				}
+		for(u_int32_t i = 0; i < scratch->length; i++){
+			if(scratch->states[i] != NULL && scratch->states[i]->opt == ACCEPTING){
+				dfa_state->accepted_patterns[dfa_state->num_accepted_patterns] = scratch->states[i]->pattern_id;
+				dfa_state->num_accepted_patterns++;
+			}
+		}
+	}
 
-				//We need to chain all of these together for the eventual memory freeing
-				previous->next = right_opt_mem;
-				previous = right_opt_mem;
-				while(previous->next != NULL){
-					previous = previous->next;
-				}
+	//Add it into the hash table
+	dfa_state->hash_next = builder->buckets[bucket];
+	builder->buckets[bucket] = dfa_state;
 
-				//In theory the entire thing should now be done so
-				return dfa_start;
-
-			//Handle an alternate split
-			case SPLIT_ALTERNATE:	
-				nfa_cursor->visited = 1;
-				//Create two separate sub-DFAs
-				left_opt = create_DFA(chain, next_idx, nfa_cursor->next, mode, '\0');
-				right_opt = create_DFA(chain, next_idx, nfa_cursor->next_opt, mode, '\0');
-
-				//Save these for later
-				left_opt_mem = left_opt;
-				right_opt_mem = right_opt;
-
-				/**
-				 * To patch this DFA in, we'll make everything in previous point to both the left
-				 * and right sub-DFAs. Unlike with a 0 or 1 split, these two separate DFAs should
-				 * never point to one another
-				 */
-				
-				//Connect previous to left_opt
-				connect_DFA_states(previous, left_opt);
+	//Add it onto the end of the chain
+	if(builder->tail == NULL){
+		builder->head = dfa_state;
+	} else {
+		builder->tail->next = dfa_state;
+	}
 
-				//Connect previous to right_opt
-				connect_DFA_states(previous, right_opt);
+	builder->tail = dfa_state;
+	builder->num_dfa_states++;
 
-				//We need to chain all of these together for the eventual memory freeing
-				previous->next = left_opt_mem;
-				previous = left_opt_mem;
-				while(previous->next != NULL){
-					previous = previous->next;
-				}
+	return dfa_state;
+}
 
-				//We need to chain all of these together for the eventual memory freeing
-				previous->next = right_opt_mem;
-				previous = right_opt_mem;
-				while(previous->next != NULL){
-					previous = previous->next;
-				}
 
-				//Get out
-				return dfa_start;
+/**
+ * Start a fresh closure in the builder's scratch list. For unanchored DFAs, every closure
+ * starts out with the start states in it
+ */
+static void begin_closure(subset_builder_t* builder){
+	//Wipe the list and its flags
+	NFA_state_t** states = builder->scratch.states;
+	memset(&(builder->scratch), 0, sizeof(NFA_state_list_t));
+	builder->scratch.states = states;
+
+	//New generation means nothing is marked
+	builder->generation++;
+
+	if(builder->unanchored == 1){
+		for(u_int32_t i = 0; i < builder->num_restarts; i++){
+			add_closure(builder, builder->starts[i]);
+		}
+	}
+}
 
-			//Handle the "0 or more" case, better known as Kleene star
-			case SPLIT_KLEENE:
-				//Mark as seen before we go any further
-				nfa_cursor->visited = 1;
 
-				//Create the entire left sub_dfa(this one does not repeat)
-				left_opt = create_DFA(chain, next_idx, nfa_cursor->next, mode, '\0');
+/**
+ * End the group that is being built in the scratch list, if anything was put in it
+ */
+static void end_closure_group(subset_builder_t* builder, u_int32_t group_start){
+	if(builder->scratch.length > group_start){
+		builder->scratch.states[builder->scratch.length] = NULL;
+		builder->scratch.length++;
+	}
+}
 
-				//IDEA -- go until we see the next guy's opt
-				right_opt = create_DFA(chain, next_idx, nfa_cursor->next_opt, mode, nfa_cursor->next->opt);
 
-				
-				//Save these for later
-				left_opt_mem = left_opt;
-				right_opt_mem = right_opt;
-
-				/**
-				 * We'll now patch in the "left_opt" such that previous points to it. We'll
-				 * then patch in right opt as well. Finally, we'll make it so that right_opt
-				 * points back to its own beginning
-				 */
-				//Connect previous to right_opt
-				connect_DFA_states(previous, right_opt);
-
-				//Connect previous to left_opt
-				connect_DFA_states(previous, left_opt);
-
-				//We'll now need to navigate to the end of the right opt repeater
-				//sub-DFA
-				cursor = right_opt;
-				
-				//Skip over
-				while(cursor->next != NULL && cursor->next->nfa_state_list.contains_accepting_state == 0){
-					cursor = cursor->next;
-				}
+/**
+ * Find where a leftmost-longest DFA state goes on "ch". Every group is stepped over the character in order, with states that
+ * an earlier group already has being left out since the earlier group would win anyway. The first group that accepts is
+ * the leftmost match, so everything after it is dropped. Until a match has been seen, a new group for a match that starts
+ * after this character is put on the end
+ */
+static void leftmost_step(subset_builder_t* builder, DFA_state_t* cursor, u_int16_t ch){
+	NFA_state_list_t* list = &(cursor->nfa_state_list);
+	u_int32_t group_start;
+	u_int32_t i = 0;
 
-				//Now that we're here, cursor holds the very end of the right sub-DFA
-				//Everything that we have in the cursor must point back to the left DFA
-				
-				//Patching in right_opt
-				//Everything that we have in the cursor must also point back to the right DFA
-				connect_DFA_states(cursor, right_opt);
+	begin_closure(builder);
+	builder->scratch.seen_match = list->seen_match;
 
-				//Connect cursor to left_opt
-				connect_DFA_states(cursor, left_opt);
-					
-				//We need to chain all of these together for the eventual memory freeing
-				previous->next = left_opt_mem;
-				previous = left_opt_mem;
-				while(previous->next != NULL){
-					previous = previous->next;
-				}
+	while(i < list->length && builder->scratch.contains_accepting_state == 0){
+		group_start = builder->scratch.length;
 
-				//We need to chain all of these together for the eventual memory freeing
-				previous->next = right_opt_mem;
-				previous = right_opt_mem;
-				while(previous->next != NULL){
-					previous = previous->next;
-				}
+		//Step everything in this group
+		for(; i < list->length && list->states[i] != NULL; i++){
+			if(nfa_state_accepts_char(list->states[i], ch) == 1){
+				add_closure(builder, list->states[i]->next);
+			}
+		}
 
-				//Get out
-				return dfa_start;
+		//Skip over the NULL at the end of the group
+		i++;
+		end_closure_group(builder, group_start);
+	}
 
-			//Handle the "1 or more" case
-			case SPLIT_POSITIVE_CLOSURE:
-				//Avoid an infinite loop
-				nfa_cursor->visited = 1;
+	//If this group accepted, nobody after it can be the leftmost match
+	if(builder->scratch.contains_accepting_state == 1){
+		builder->scratch.seen_match = 1;
+	}
 
-				//Create the left DFA
-				left_opt = create_DFA(chain, next_idx, nfa_cursor->next, mode, '\0');
-				//Create the right DFA
-				//Where does it go to
-				right_opt = create_DFA_state(nfa_cursor->next_opt, chain, next_idx);
+	//Otherwise a new match could start right after this character
+	if(builder->scratch.seen_match == 0){
+		group_start = builder->scratch.length;
 
-				//Save these for later
-				left_opt_mem = left_opt;
+		for(u_int32_t j = 0; j < builder->num_restarts; j++){
+			add_closure(builder, builder->starts[j]);
+		}
 
-				//Let's now search for the correct state that we need to point to
-				for(u_int16_t i = 0; i < *next_idx; i++){
-					cursor = chain[i];
-					//We've found the right one
-					if(dfa_states_equal(cursor, right_opt) == 1){
-						break;
-					} 
-				}
+		end_closure_group(builder, group_start);
 
-				//No longer need this
-				free(right_opt);
-				//This one is what we care about
-				right_opt = cursor;
-
-				/**
-				 * We'll now patch in the "left_opt" such that previous points to it. We'll
-				 * then patch in right opt as well. Finally, we'll make it so that right_opt
-				 * points back to its own beginning
-				 */
-		
-				//Connect previous to right_opt
-				connect_DFA_states(previous, right_opt);
-				//Connect previous to left_opt
-				connect_DFA_states(previous, left_opt);
-	
-				//We'll now need to navigate to the end of the right opt repeater
-				//sub-DFA
+		if(builder->scratch.contains_accepting_state == 1){
+			builder->scratch.seen_match = 1;
+		}
+	}
+}
 
-				previous->next = left_opt_mem;
-				previous = left_opt_mem;
-				while(previous->next != NULL){
-					previous = previous->next;
-				}
 
-				//Get out
-				return dfa_start;
+/**
+ * Allocate a subset builder along with all of its scratch space
+ */
+static subset_builder_t* create_subset_builder(NFA_state_t** starts, u_int32_t num_starts, u_int32_t num_nfa_states){
+	subset_builder_t* builder = calloc(1, sizeof(subset_builder_t));
+	builder->starts = starts;
+	builder->num_starts = num_starts;
+	builder->num_restarts = num_starts;
+	builder->num_nfa_states = num_nfa_states;
+	builder->max_states = DFA_MAX_STATES;
+	builder->marks = calloc(num_nfa_states, sizeof(u_int32_t));
+	//Every state can be pushed at most twice, once by each of the splits that points to it
+	builder->dfs_stack = calloc(2 * num_nfa_states + 1, sizeof(NFA_state_t*));
+	//Leftmost-longest lists can have a NULL after every state
+	builder->scratch.states = calloc(2 * num_nfa_states + 1, sizeof(NFA_state_t*));
+	builder->spare = calloc(2 * num_nfa_states + 1, sizeof(NFA_state_t*));
+
+	return builder;
+}
 
-			default:
-				//Create our state
-				temp = create_DFA_state(nfa_cursor, chain, next_idx);
-				//Connect previous to temp
-				connect_DFA_states(previous, temp);
-			
-				//Advance the current DFA pointer
-				previous->next = temp;
-				previous = temp;
 
-				//Advance the pointer
-				nfa_cursor = nfa_cursor->next;
-				break;
-		}
+/**
+ * Clean up all of a subset builder's scratch space. The DFA states that it made are left alone
+ */
+static void destroy_subset_builder(subset_builder_t* builder){
+	for(u_int32_t i = 0; i < builder->num_consuming; i++){
+		free(builder->closures[i]);
 	}
 
-	//Return a pointer to the start state
-	return dfa_start;
+	free(builder->closures);
+	free(builder->closure_lengths);
+	free(builder->consuming);
+	free(builder->start_closure);
+	free(builder->marks);
+	free(builder->dfs_stack);
+	free(builder->scratch.states);
+	free(builder->spare);
+	free(builder);
 }
 
 
-/* ================================================ End DFA Methods ================================================ */
+/**
+ * Throw out every DFA state that the builder has made, so that it can start over from nothing
+ */
+static void reset_subset_builder(subset_builder_t* builder){
+	teardown_DFA(builder->head);
+	builder->head = NULL;
+	builder->tail = NULL;
+	builder->num_dfa_states = 0;
+	memset(builder->buckets, 0, sizeof(builder->buckets));
+}
 
 
 /**
- * Build an NFA and then DFA for a regular expression defined by the pattern
- * passed in.
- *
- * If anything goes wrong, a regex_t struct will be returned in a REGEX_ERR state. This regex
- * will then be useless by the match function
+ * Get a builder ready to make reverse DFA states. Thompson NFAs only have arrows going forwards, so we find every state that
+ * consumes a character, and everything that we can get to right after it consumes one. Returns 0 if the NFA has no accepting state
  */
-regex_t* define_regular_expression(char* pattern, regex_mode_t mode){
-	//Stack allocate a regex
-	regex_t* regex = calloc(1, sizeof(regex_t));
-	//Set to NULL as a flag
-	regex->NFA = NULL;
-	regex->creation_chain = NULL;
-	regex->DFA = NULL;
+static u_int8_t prepare_reverse_builder(subset_builder_t* builder, NFA_state_t* creation_chain){
+	builder->reverse = 1;
+	builder->consuming = calloc(builder->num_nfa_states, sizeof(NFA_state_t*));
+	builder->closures = calloc(builder->num_nfa_states, sizeof(u_int32_t*));
+	builder->closure_lengths = calloc(builder->num_nfa_states, sizeof(u_int32_t));
+
+	for(NFA_state_t* cursor = creation_chain; cursor != NULL; cursor = cursor->next_created){
+		if(cursor->opt == ACCEPTING){
+			builder->accepting_state = cursor;
+			continue;
+		}
 
-	//Just in case
-	if(pattern == NULL || strlen(pattern) == 0){
-		//Verbose mode
-		if(mode == REGEX_VERBOSE){
-			printf("REGEX ERROR: Pattern cannot be null or empty\n");
+		if(is_split_state(cursor) == 1){
+			continue;
 		}
 
-		//Set this flag so that the user knows
-		regex->state = REGEX_ERR;
-		return regex;
-	}
+		begin_closure(builder);
+		add_closure(builder, cursor->next);
 
-	//Set a hard limit. I don't see a situation where we'd need more than 150 characters for a regex
-	if(strlen(pattern) >= REGEX_LEN){
-		//Verbose mode
-		if(mode == REGEX_VERBOSE){
-			printf("REGEX ERROR: Patterns of size 150 or more not supported\n");
+		builder->consuming[builder->num_consuming] = cursor;
+		builder->closure_lengths[builder->num_consuming] = builder->scratch.length;
+		builder->closures[builder->num_consuming] = malloc((builder->scratch.length + 1) * sizeof(u_int32_t));
+		for(u_int32_t i = 0; i < builder->scratch.length; i++){
+			builder->closures[builder->num_consuming][i] = builder->scratch.states[i]->id;
 		}
 
-		regex->state = REGEX_ERR;
-		return regex;
+		builder->num_consuming++;
 	}
 
-	//Convert to postfix before applying our algorithm
-	char* postfix = in_to_post(pattern, mode);
-	//Save for reference
-	regex->regex = postfix;
+	//Everything that a match can start on
+	begin_closure(builder);
+	add_closure(builder, builder->starts[0]);
+	builder->start_closure_length = builder->scratch.length;
+	builder->start_closure = malloc((builder->start_closure_length + 1) * sizeof(u_int32_t));
+	for(u_int32_t i = 0; i < builder->start_closure_length; i++){
+		builder->start_closure[i] = builder->scratch.states[i]->id;
+	}
 
-	//If this didn't work, we will stop and return a bad regex
-	if(postfix == NULL){
-		//Verbose mode
-		if(mode == REGEX_VERBOSE){
-			printf("REGEX ERROR: Postfix conversion failed.\n");
-		}
+	return builder->accepting_state != NULL;
+}
 
-		//Put in error state
-		regex->state = REGEX_ERR;
-		return regex;
-	}
 
-	//Show postfix if it exists
-	if(mode == REGEX_VERBOSE){
-		printf("Postfix conversion: %s\n", postfix);
+/**
+ * Find where a reverse DFA state goes on "ch". Each reverse state is the set of NFA states that we could be about to leave
+ * from and still make it to the accepting state, so stepping backwards over "ch" gives us every state that consumes "ch" and
+ * whose closure reaches something in our set. We accept whenever the closure of the NFA's start state reaches something in our set
+ */
+static void reverse_step(subset_builder_t* builder, DFA_state_t* cursor, u_int16_t ch){
+	//Mark everything in this state so that we can check the closures against it
+	builder->generation++;
+	for(u_int32_t i = 0; i < cursor->nfa_state_list.length; i++){
+		builder->marks[cursor->nfa_state_list.states[i]->id] = builder->generation;
 	}
 
-	//Create the NFA first
-	 create_NFA(regex, postfix, mode);
+	u_int32_t marked = builder->generation;
 
-	//If this is bad, we'll bail out here
-	if(regex->NFA == NULL){
-		if(mode == REGEX_VERBOSE){
-			printf("REGEX ERROR: NFA creation failed.\n");
-		
-			//Ensure there is no leakage
-			free(postfix);
+	//Start the new set
+	NFA_state_t** states = builder->scratch.states;
+	memset(&(builder->scratch), 0, sizeof(NFA_state_list_t));
+	builder->scratch.states = states;
+
+	//Every state that consumes this character and leads into our set
+	for(u_int32_t i = 0; i < builder->num_consuming; i++){
+		if(nfa_state_accepts_char(builder->consuming[i], ch) == 0){
+			continue;
+		}
 
-			return regex;
+		for(u_int32_t j = 0; j < builder->closure_lengths[i]; j++){
+			if(builder->marks[builder->closures[i][j]] == marked){
+				builder->scratch.states[builder->scratch.length] = builder->consuming[i];
+				builder->scratch.length++;
+				break;
+			}
 		}
 	}
 
-	//Display if desired
-	if(mode == REGEX_VERBOSE){
-		printf("\nNFA conversion succeeded.\n");
-		print_NFA(regex->NFA);
-		printf("\n\nBeginning DFA Conversion.\n\n");
+	//Now see if a match could start right here
+	builder->generation++;
+	for(u_int32_t i = 0; i < builder->scratch.length; i++){
+		builder->marks[builder->scratch.states[i]->id] = builder->generation;
 	}
 
-	//Now we'll use the NFA to create the DFA. We'll do this because DFA's are much more
-	//efficient to simulate since they are determinsitic, but they are much harder to create
-	//from regular expressions
-	DFA_state_t* chain[1000];
-	//Wipe it
-	memset(chain, 0, 1000*sizeof(DFA_state_t*));
-	u_int16_t next_idx = 0;
+	for(u_int32_t i = 0; i < builder->start_closure_length; i++){
+		if(builder->marks[builder->start_closure[i]] == builder->generation){
+			builder->scratch.contains_accepting_state = 1;
+			break;
+		}
+	}
+}
 
-	//Create the DFA
-	regex->DFA = create_DFA(chain, &next_idx, regex->NFA, mode, '\0');
 
-	//If it didn't work
-	if(regex->DFA == NULL){
+/**
+ * Find or make the builder's start state. This is always the first state that a builder makes, so it always has id 0
+ */
+static DFA_state_t* start_subset_state(subset_builder_t* builder){
+	//Reverse DFAs start at the end of the match, right on the accepting state. If the start closure has it, the empty string matches
+	if(builder->reverse == 1){
+		begin_closure(builder);
+		builder->scratch.states[0] = builder->accepting_state;
+		builder->scratch.length = 1;
+
+		for(u_int32_t i = 0; i < builder->start_closure_length; i++){
+			if(builder->start_closure[i] == builder->accepting_state->id){
+				builder->scratch.contains_accepting_state = 1;
+			}
+		}
+
+		return find_or_create_subset_state(builder);
+	}
+
+	//The start state is the closure of all of the starts. Unanchored closures already have every start that gets added back in,
+	//so all that's left for them are the anchored ones
+	begin_closure(builder);
+	for(u_int32_t i = (builder->unanchored == 1 ? builder->num_restarts : 0); i < builder->num_starts; i++){
+		add_closure(builder, builder->starts[i]);
+	}
+
+	//The start state is the first and only group. If it accepts, the leftmost match starts right here
+	if(builder->leftmost == 1){
+		end_closure_group(builder, 0);
+		builder->scratch.seen_match = builder->scratch.contains_accepting_state;
+	}
+
+	return find_or_create_subset_state(builder);
+}
+
+
+/**
+ * Put every NFA state that "cursor" goes to on "ch" into the builder's scratch list, following whichever rules this DFA has
+ */
+static void step_subset_state(subset_builder_t* builder, DFA_state_t* cursor, u_int16_t ch){
+	NFA_state_t* nfa_state;
+
+	//Leftmost-longest and reverse states have their own rules
+	if(builder->leftmost == 1){
+		leftmost_step(builder, cursor, ch);
+		return;
+	}
+
+	if(builder->reverse == 1){
+		reverse_step(builder, cursor, ch);
+		return;
+	}
+
+	begin_closure(builder);
+
+	for(u_int32_t i = 0; i < cursor->nfa_state_list.length; i++){
+		nfa_state = cursor->nfa_state_list.states[i];
+
+		//If this state consumes the character, we can go wherever it goes
+		if(nfa_state_accepts_char(nfa_state, ch) == 1){
+			add_closure(builder, nfa_state->next);
+		}
+	}
+}
+
+
+/**
+ * Make every state in the builder's DFA up front. Returns the start state, with every other state chained after it through
+ * "next". If the DFA would need more than the builder's limit, every state is thrown out and NULL is returned
+ */
+static DFA_state_t* build_subset_states(subset_builder_t* builder){
+	DFA_state_t* dfa_start = start_subset_state(builder);
+
+	//Every state that we make goes on the end of the chain, so we can just walk the chain until we run out
+	for(DFA_state_t* cursor = dfa_start; cursor != NULL; cursor = cursor->next){
+		//Find where we go on every character
+		for(u_int16_t ch = 0; ch < 256; ch++){
+			step_subset_state(builder, cursor, ch);
+			cursor->transitions[ch] = find_or_create_subset_state(builder);
+
+			//If we got nothing back for a non-empty set, we've run out of room
+			if(cursor->transitions[ch] == NULL && builder->scratch.length > 0){
+				reset_subset_builder(builder);
+				return NULL;
+			}
+		}
+	}
+
+	return dfa_start;
+}
+
+
+/**
+ * Build a DFA out of one or more NFAs using the subset construction. Every DFA state is the set of NFA states that we could
+ * be in at the same time, and its transitions are found by stepping every one of those NFA states over each character. Returns the
+ * start state of the DFA, with every other state chained after it through "next". If the DFA would need more than DFA_MAX_STATES
+ * states, everything is cleaned up and NULL is returned. Unanchored DFAs look for a match anywhere, and leftmost DFAs are
+ * unanchored DFAs that only keep track of the leftmost match once one has been seen. The last "num_anchored" starts can only
+ * begin a match at the very start of the input, even in an unanchored DFA
+ */
+static DFA_state_t* subset_construction(NFA_state_t** starts, u_int32_t num_starts, u_int32_t num_anchored, u_int32_t num_nfa_states, u_int8_t unanchored, u_int8_t leftmost){
+	subset_builder_t* builder = create_subset_builder(starts, num_starts, num_nfa_states);
+	builder->num_restarts = num_starts - num_anchored;
+	//Leftmost-longest DFAs add the start states themselves, as their own group
+	builder->unanchored = unanchored == 1 && leftmost == 0;
+	builder->leftmost = leftmost;
+
+	DFA_state_t* dfa_start = build_subset_states(builder);
+
+	destroy_subset_builder(builder);
+
+	return dfa_start;
+}
+
+
+/**
+ * Set up a builder for one of a regex's DFAs. The reverse DFA reads the input backwards, starting from the place where a match
+ * ends, and it accepts at every place that a match ending there could have started. This lets us find the start of a match in
+ * one backwards pass once the forward DFA has told us where it ends. Returns NULL if the DFA can't be built
+ */
+static subset_builder_t* create_regex_builder(regex_t* regex, DFA_kind_t kind, u_int32_t num_nfa_states){
+	subset_builder_t* builder = create_subset_builder((NFA_state_t**)&(regex->NFA), 1, num_nfa_states);
+
+	switch(kind){
+		//The anchored DFA never goes back to the start
+		case DFA_ANCHORED:
+			break;
+
+		//Earliest matches just need to know when any match has ended, but leftmost-longest matches need to keep track of which
+		//match started first. Leftmost-longest DFAs add the start states themselves, as their own group
+		case DFA_FORWARD:
+			builder->leftmost = (regex->flags & REGEX_EARLIEST) == 0;
+			builder->unanchored = builder->leftmost == 0;
+			break;
+
+		case DFA_REVERSE:
+			//This should never happen, but there's nothing to build if it does
+			if(prepare_reverse_builder(builder, (NFA_state_t*)(regex->creation_chain)) == 0){
+				destroy_subset_builder(builder);
+				return NULL;
+			}
+
+			break;
+	}
+
+	return builder;
+}
+
+
+/**
+ * Pack a DFA state into what goes in a transition table: where its row starts, along with its flags. A NULL state
+ * is dead and has no row at all
+ */
+static u_int32_t pack_DFA_state(transition_table_t* table, DFA_state_t* state){
+	if(state == NULL){
+		return TRANSITION_DEAD;
+	}
+
+	u_int32_t packed = state->id << 8;
+
+	if(state->nfa_state_list.contains_accepting_state == 1){
+		packed |= TRANSITION_ACCEPTING;
+	}
+
+	if(state->id == 0 && table->skip_start == 1){
+		packed |= TRANSITION_START;
+	}
+
+	return packed;
+}
+
+
+/**
+ * Get the packed start state of a table. The start state is always the first one that was made, so it's always in row 0
+ */
+static u_int32_t table_start(transition_table_t* table){
+	return pack_DFA_state(table, table->states[0]);
+}
+
+
+/**
+ * Flatten a DFA into a transition table. States are numbered in the order that they were made, which is also the order of
+ * the chain, so a state's row is just its id * 256
+ */
+static transition_table_t* build_transition_table(DFA_state_t* start){
+	transition_table_t* table = calloc(1, sizeof(transition_table_t));
+
+	for(DFA_state_t* cursor = start; cursor != NULL; cursor = cursor->next){
+		table->num_states++;
+	}
+
+	table->capacity = table->num_states;
+	table->transitions = malloc(table->num_states * 256 * sizeof(u_int32_t));
+	table->states = malloc(table->num_states * sizeof(DFA_state_t*));
+
+	for(DFA_state_t* cursor = start; cursor != NULL; cursor = cursor->next){
+		u_int32_t* row = table->transitions + (cursor->id << 8);
+
+		for(u_int16_t ch = 0; ch < 256; ch++){
+			row[ch] = pack_DFA_state(table, cursor->transitions[ch]);
+		}
+
+		table->states[cursor->id] = cursor;
+	}
+
+	return table;
+}
+
+
+/**
+ * Add a state that a lazy builder just made onto the end of its table. We don't know where it goes on anything yet. The
+ * table only grows as big as it has to, up to LAZY_DFA_MAX_STATES states
+ */
+static void add_table_state(transition_table_t* table, DFA_state_t* state){
+	//Make room if we have to
+	if(table->num_states == table->capacity){
+		table->capacity *= 2;
+		table->transitions = realloc(table->transitions, table->capacity * 256 * sizeof(u_int32_t));
+		table->states = realloc(table->states, table->capacity * sizeof(DFA_state_t*));
+	}
+
+	u_int32_t* row = table->transitions + (state->id << 8);
+
+	for(u_int16_t ch = 0; ch < 256; ch++){
+		row[ch] = TRANSITION_UNKNOWN;
+	}
+
+	table->states[state->id] = state;
+	table->num_states++;
+}
+
+
+/**
+ * Make a lazy table out of a builder. All that we make up front is the start state, and everything else is made the
+ * first time that it's needed. The table owns the builder from here on out
+ */
+static transition_table_t* create_lazy_table(subset_builder_t* builder){
+	transition_table_t* table = calloc(1, sizeof(transition_table_t));
+	table->builder = builder;
+	table->capacity = 16;
+	table->transitions = malloc(table->capacity * 256 * sizeof(u_int32_t));
+	table->states = malloc(table->capacity * sizeof(DFA_state_t*));
+
+	builder->lazy = 1;
+	builder->max_states = LAZY_DFA_MAX_STATES;
+
+	add_table_state(table, start_subset_state(builder));
+
+	return table;
+}
+
+
+/**
+ * A lazy table is full, so we throw out every state in it and start over with just the start state. The set that the builder
+ * has in its scratch list is the one that we were trying to add, so we hold on to it while the start state is made
+ */
+static void flush_lazy_table(transition_table_t* table){
+	subset_builder_t* builder = table->builder;
+	NFA_state_list_t pending = builder->scratch;
+
+	//The start state gets made in the spare list
+	builder->scratch.states = builder->spare;
+
+	reset_subset_builder(builder);
+	table->num_states = 0;
+	table->generation++;
+
+	add_table_state(table, start_subset_state(builder));
+
+	//Now put the pending set back
+	builder->spare = builder->scratch.states;
+	builder->scratch = pending;
+}
+
+
+/**
+ * Work out where the state in "row" of a lazy table goes on "ch", making the next state if we've never seen it. If the
+ * table is full, it's flushed first. That means that "row" is gone, so only the state that we hand back can be used afterwards
+ */
+static u_int32_t lazy_transition(transition_table_t* table, size_t row, u_int8_t ch){
+	subset_builder_t* builder = table->builder;
+
+	step_subset_state(builder, table->states[row >> 8], ch);
+
+	//Nothing here means that we're dead
+	if(builder->scratch.length == 0){
+		table->transitions[row + ch] = TRANSITION_DEAD;
+		return TRANSITION_DEAD;
+	}
+
+	DFA_state_t* next_state = find_or_create_subset_state(builder);
+
+	//There's no room left, so we'll start over. The start state is all that will be in there, so there's room now
+	if(next_state == NULL){
+		flush_lazy_table(table);
+		next_state = find_or_create_subset_state(builder);
+
+		if(next_state->id == table->num_states){
+			add_table_state(table, next_state);
+		}
+
+		return pack_DFA_state(table, next_state);
+	}
+
+	if(next_state->id == table->num_states){
+		add_table_state(table, next_state);
+	}
+
+	table->transitions[row + ch] = pack_DFA_state(table, next_state);
+
+	return table->transitions[row + ch];
+}
+
+
+/**
+ * Look up where the state in "row" goes on "ch", working it out first if the table is lazy and we haven't needed it yet.
+ * The match loops do this lookup themselves, so this is only for places where speed doesn't matter as much
+ */
+static u_int32_t table_transition(transition_table_t* table, size_t row, u_int8_t ch){
+	u_int32_t next_state = table->transitions[row + ch];
+
+	if((next_state & TRANSITION_UNKNOWN) != 0){
+		next_state = lazy_transition(table, row, ch);
+	}
+
+	return next_state;
+}
+
+
+/**
+ * Mark every transition into the start state with TRANSITION_START, along with any that get made later on
+ */
+static void enable_start_skipping(transition_table_t* table){
+	table->skip_start = 1;
+
+	for(size_t i = 0; i < (size_t)(table->num_states) * 256; i++){
+		if((table->transitions[i] & (TRANSITION_DEAD | TRANSITION_UNKNOWN)) == 0 && (table->transitions[i] & TRANSITION_ROW_MASK) == 0){
+			table->transitions[i] |= TRANSITION_START;
+		}
+	}
+}
+
+
+/**
+ * Build one of a regex's DFAs and flatten it into a table. Unless the regex was compiled with REGEX_LAZY, every state is made up
+ * front, and if that would need more than DFA_MAX_STATES states, the DFA can't be built. We never go lazy on our own, since a lazy
+ * table changes as it's searched, and the caller has no way of knowing that the regex can't be shared between threads anymore.
+ * "dfa" gets the start of the full DFA, or NULL if the table is lazy. Returns NULL if the DFA can't be built at all
+ */
+static transition_table_t* build_regex_DFA(regex_t* regex, DFA_kind_t kind, u_int32_t num_nfa_states, void** dfa, regex_mode_t mode){
+	subset_builder_t* builder = create_regex_builder(regex, kind, num_nfa_states);
+	*dfa = NULL;
+
+	if(builder == NULL){
+		return NULL;
+	}
+
+	if((regex->flags & REGEX_LAZY) != 0){
+		return create_lazy_table(builder);
+	}
+
+	*dfa = build_subset_states(builder);
+	destroy_subset_builder(builder);
+
+	if(*dfa == NULL){
+		if(mode == REGEX_VERBOSE){
+			printf("DFA needs more than %d states, so it can't be built up front\n", DFA_MAX_STATES);
+		}
+
+		return NULL;
+	}
+
+	return build_transition_table((DFA_state_t*)(*dfa));
+}
+
+
+/**
+ * Free a transition table. Lazy tables own all of their states, so those go too
+ */
+static void destroy_transition_table(transition_table_t* table){
+	if(table == NULL){
+		return;
+	}
+
+	if(table->builder != NULL){
+		reset_subset_builder(table->builder);
+		destroy_subset_builder(table->builder);
+	}
+
+	free(table->transitions);
+	free(table->states);
+	free(table);
+}
+
+
+/* ================================================ End DFA Methods ================================================ */
+
+
+/* ================================================ Pike VM Methods ================================================ */
+
+//Marks an instruction that has nowhere to go on one of its arrows
+#define PIKE_NO_TARGET 0xFFFFFFFF
+
+//The Pike VM skips ahead and gives up early the same way that the DFA searches do, but those live further down with the match functions
+static u_int8_t contains_required_factor(required_factors_t* factors, const char* buffer, size_t length);
+static const char* find_match_candidate(regex_t* regex, const char* buffer, size_t length);
+
+
+/**
+ * One instruction of the Pike VM. Every NFA state becomes exactly one instruction, found at the state's id,
+ * so the arrows between states are just indices into the program
+ */
+typedef struct {
+	//The NFA state's opt. This is what it consumes, or if it's a split or accepting state
+	u_int16_t opt;
+	//Where we go next, and for splits, the other place that we can go
+	u_int32_t next;
+	u_int32_t next_opt;
+} pike_instruction_t;
+
+
+/**
+ * The NFA flattened into one array of instructions. This is all that the Pike VM needs, so the NFA's
+ * pointers never have to be chased while matching
+ */
+typedef struct {
+	pike_instruction_t* instructions;
+	u_int32_t num_instructions;
+	//The instruction that every match starts from
+	u_int32_t start;
+} pike_program_t;
+
+
+/**
+ * The threads that the Pike VM is running, kept in a sparse set. An instruction is in the set if sparse[pc] is below length
+ * and dense[sparse[pc]] is pc, so adding, checking and clearing are all constant time. Threads are kept in the order that
+ * they started, so the thread at dense[i] started at starts[i], and those only ever go up
+ */
+typedef struct {
+	u_int32_t* dense;
+	u_int32_t* sparse;
+	size_t* starts;
+	u_int32_t length;
+} pike_thread_list_t;
+
+
+/**
+ * Flatten the NFA into a Pike VM program. The states have to be numbered first, since their ids
+ * become where they live in the program
+ */
+static pike_program_t* compile_pike_program(regex_t* regex, u_int32_t num_nfa_states){
+	pike_program_t* program = calloc(1, sizeof(pike_program_t));
+	program->instructions = calloc(num_nfa_states, sizeof(pike_instruction_t));
+	program->num_instructions = num_nfa_states;
+	program->start = ((NFA_state_t*)(regex->NFA))->id;
+
+	for(NFA_state_t* cursor = (NFA_state_t*)(regex->creation_chain); cursor != NULL; cursor = cursor->next_created){
+		pike_instruction_t* instruction = &(program->instructions[cursor->id]);
+
+		instruction->opt = cursor->opt;
+		instruction->next = cursor->next == NULL ? PIKE_NO_TARGET : cursor->next->id;
+		instruction->next_opt = cursor->next_opt == NULL ? PIKE_NO_TARGET : cursor->next_opt->id;
+	}
+
+	return program;
+}
+
+
+/**
+ * Free a Pike VM program
+ */
+static void destroy_pike_program(pike_program_t* program){
+	if(program == NULL){
+		return;
+	}
+
+	free(program->instructions);
+	free(program);
+}
+
+
+/**
+ * Add a thread at "pc" that started at "start", along with every thread that its splits lead to. If an instruction is already
+ * in the list, a thread that started no later than this one got there first, and whatever this one could match, that one
+ * can match too, so we leave it be. Splits are kept in the list as well, so that they're only ever followed once
+ */
+static void add_pike_thread(pike_program_t* program, pike_thread_list_t* list, u_int32_t* stack, u_int32_t pc, size_t start){
+	u_int32_t stack_top = 0;
+	pike_instruction_t* instruction;
+
+	if(pc != PIKE_NO_TARGET){
+		stack[stack_top] = pc;
+		stack_top++;
+	}
+
+	while(stack_top > 0){
+		stack_top--;
+		pc = stack[stack_top];
+
+		//Already here
+		if(list->sparse[pc] < list->length && list->dense[list->sparse[pc]] == pc){
+			continue;
+		}
+
+		list->sparse[pc] = list->length;
+		list->dense[list->length] = pc;
+		list->starts[list->length] = start;
+		list->length++;
+
+		instruction = &(program->instructions[pc]);
+
+		//Splits give us two more places to be
+		if(instruction->opt >= SPLIT_ZERO_OR_ONE && instruction->opt <= SPLIT_POSITIVE_CLOSURE){
+			if(instruction->next_opt != PIKE_NO_TARGET){
+				stack[stack_top] = instruction->next_opt;
+				stack_top++;
+			}
+
+			if(instruction->next != PIKE_NO_TARGET){
+				stack[stack_top] = instruction->next;
+				stack_top++;
+			}
+		}
+	}
+}
+
+
+/**
+ * Find a match by simulating the NFA directly. Every thread remembers where its match started, and the thread list holds each
+ * instruction at most once, so each byte costs at most one step per instruction no matter what the pattern is. A new thread is
+ * started at every byte until something accepts. For earliest matches we stop right there, and otherwise we keep going until every
+ * thread that started no later than the match is gone, taking the longest match from the leftmost start that we've seen. For a full
+ * match, only accepting once every byte is used up counts. This finds the exact same matches as the DFAs do. Only simulate_NFA
+ * should call this, since it does all of the checks that come first
+ */
+static void pike_match(regex_match_t* match, regex_t* regex, const char* buffer, size_t length, size_t starting_index, u_int8_t full, regex_mode_t mode){
+	pike_program_t* program = (pike_program_t*)(regex->program);
+	//Full matches and ^ can only start at the very beginning
+	u_int8_t anchored = full == 1 || regex->anchored_start == 1;
+	//Earliest searches stop as soon as they've found something
+	u_int8_t earliest = full == 0 && (regex->flags & REGEX_EARLIEST) != 0;
+	//We can only skip ahead if we know what a match starts with
+	u_int8_t can_skip = anchored == 0 && (regex->literal_prefix != NULL || regex->start_set != NULL);
+	u_int8_t found = 0;
+	size_t best_start = starting_index;
+	size_t best_end = starting_index;
+	pike_thread_list_t lists[2];
+	pike_thread_list_t* current = &(lists[0]);
+	pike_thread_list_t* next = &(lists[1]);
+	pike_thread_list_t* swap;
+	pike_instruction_t* instruction;
+
+	//Every instruction can be pushed at most twice, once by each of the splits that points to it
+	u_int32_t* stack = malloc((2 * program->num_instructions + 1) * sizeof(u_int32_t));
+
+	for(u_int8_t i = 0; i < 2; i++){
+		lists[i].dense = malloc(program->num_instructions * sizeof(u_int32_t));
+		lists[i].sparse = calloc(program->num_instructions, sizeof(u_int32_t));
+		lists[i].starts = malloc(program->num_instructions * sizeof(size_t));
+		lists[i].length = 0;
+	}
+
+	for(size_t current_index = starting_index; ; current_index++){
+		//Nothing that starts after a match that we've already found can beat it, so we only start new threads until then
+		if(found == 0 && (anchored == 0 || current_index == starting_index)){
+			//If nothing is running, we can jump straight to the next place that a match could start
+			if(can_skip == 1 && current->length == 0){
+				const char* candidate = find_match_candidate(regex, buffer + current_index, length - current_index);
+
+				if(candidate == NULL){
+					break;
+				}
+
+				current_index = candidate - buffer;
+			}
+
+			add_pike_thread(program, current, stack, program->start, current_index);
+		}
+
+		//The threads are in the order that they started, so the first one that accepts has the leftmost start
+		for(u_int32_t i = 0; i < current->length; i++){
+			if(program->instructions[current->dense[i]].opt != ACCEPTING){
+				continue;
+			}
+
+			if((full == 0 || current_index == length) && (found == 0 || current->starts[i] <= best_start)){
+				found = 1;
+				best_start = current->starts[i];
+				best_end = current_index;
+
+				if(mode == REGEX_VERBOSE){
+					printf("Accepting at index %zu for a match that started at %zu\n", current_index, best_start);
+				}
+			}
+
+			break;
+		}
+
+		//Once we're out of input or threads, we're done
+		if(current_index >= length || (earliest == 1 && found == 1) || (current->length == 0 && (found == 1 || anchored == 1))){
+			break;
+		}
+
+		u_int8_t ch = (u_int8_t)buffer[current_index];
+		next->length = 0;
+
+		//Step every thread over this byte, in order, so that the next list stays in the order that they started
+		for(u_int32_t i = 0; i < current->length; i++){
+			//This can't beat the match that we've got
+			if(found == 1 && current->starts[i] > best_start){
+				break;
+			}
+
+			instruction = &(program->instructions[current->dense[i]]);
+
+			//Splits and the accepting state don't consume anything, and opt_accepts_char never matches them
+			if(opt_accepts_char(instruction->opt, ch) == 1){
+				add_pike_thread(program, next, stack, instruction->next, current->starts[i]);
+			}
+		}
+
+		swap = current;
+		current = next;
+		next = swap;
+	}
+
+	free(stack);
+
+	for(u_int8_t i = 0; i < 2; i++){
+		free(lists[i].dense);
+		free(lists[i].sparse);
+		free(lists[i].starts);
+	}
+
+	if(found == 1){
+		match->match_start_idx = best_start;
+		match->match_end_idx = best_end;
+		match->status = MATCH_FOUND;
+
+		if(mode == REGEX_VERBOSE){
+			printf("Match found!\n");
+		}
+	}
+}
+
+
+/* ============================================== End Pike VM Methods ============================================== */
+
+
+/* ============================================= Bit-Parallel Methods ============================================== */
+
+
+/**
+ * The pattern's position(Glushkov) automaton, packed into bits so that a whole set of states fits in one 64 bit word. Every
+ * NFA state that consumes a character is a position, and positions are numbered in the order that they were made. A set
+ * of states is the positions that we've just consumed, and one more bit after all of them stands for the state that we're
+ * in before consuming anything. Stepping over a byte is then follow(D) & accepts[ch], where follow(D) is every position that
+ * can come right after one in D. That's worked out one byte of D at a time, with a table for each byte, so there are no branches
+ */
+typedef struct {
+	//follow[k][byte] is every position that can come right after any of the ones set in "byte", which is bits 8k to 8k + 7 of a set
+	u_int64_t (*follow)[256];
+	u_int32_t num_follow_tables;
+	//Every position that consumes ch
+	u_int64_t accepts[256];
+	//Every state that a match can end in
+	u_int64_t last;
+	//The state that we're in before consuming anything
+	u_int64_t initial;
+	u_int32_t num_positions;
+} glushkov_t;
+
+
+/**
+ * Build the position automaton out of the NFA, which has to have been numbered. Following a position's "next" arrow through
+ * every split gives us everything that can come right after it, and the same goes for the NFA's start state and what can come
+ * first. Returns NULL if there are more than GLUSHKOV_MAX_POSITIONS positions, since those won't fit in a word
+ */
+static glushkov_t* compile_glushkov(regex_t* regex, u_int32_t num_nfa_states){
+	u_int32_t* positions = malloc(num_nfa_states * sizeof(u_int32_t));
+	NFA_state_t** by_id = calloc(num_nfa_states, sizeof(NFA_state_t*));
+	u_int32_t num_positions = 0;
+
+	//Number every state that consumes something
+	for(NFA_state_t* cursor = (NFA_state_t*)(regex->creation_chain); cursor != NULL; cursor = cursor->next_created){
+		by_id[cursor->id] = cursor;
+	}
+
+	for(u_int32_t id = 0; id < num_nfa_states; id++){
+		if(by_id[id]->opt != ACCEPTING && is_split_state(by_id[id]) == 0){
+			positions[id] = num_positions;
+			num_positions++;
+		}
+	}
+
+	if(num_positions > GLUSHKOV_MAX_POSITIONS){
+		free(positions);
+		free(by_id);
+		return NULL;
+	}
+
+	glushkov_t* glushkov = calloc(1, sizeof(glushkov_t));
+	glushkov->num_positions = num_positions;
+	glushkov->initial = (u_int64_t)1 << num_positions;
+	//The initial state needs a bit in the tables too
+	glushkov->num_follow_tables = (num_positions + 1 + 7) / 8;
+	glushkov->follow = calloc(glushkov->num_follow_tables, sizeof(u_int64_t[256]));
+
+	//Everything that can come right after each position, with the initial state at the very end
+	u_int64_t* follow = calloc(num_positions + 1, sizeof(u_int64_t));
+	u_int32_t* marks = calloc(num_nfa_states, sizeof(u_int32_t));
+	//Every state can be pushed at most twice, once by each of the splits that points to it
+	NFA_state_t** stack = malloc((2 * num_nfa_states + 1) * sizeof(NFA_state_t*));
+	u_int32_t stack_top;
+	NFA_state_t* state;
+
+	for(u_int32_t id = 0; id <= num_nfa_states; id++){
+		u_int32_t from;
+		stack_top = 0;
+
+		//The last pass is for the initial state
+		if(id == num_nfa_states){
+			from = num_positions;
+			stack[stack_top] = (NFA_state_t*)(regex->NFA);
+			stack_top++;
+		} else if(by_id[id]->opt != ACCEPTING && is_split_state(by_id[id]) == 0){
+			from = positions[id];
+
+			if(by_id[id]->next != NULL){
+				stack[stack_top] = by_id[id]->next;
+				stack_top++;
+			}
+		} else {
+			continue;
+		}
+
+		while(stack_top > 0){
+			stack_top--;
+			state = stack[stack_top];
+
+			//The marks are one more than the pass that saw them, so that 0 means never seen
+			if(marks[state->id] == id + 1){
+				continue;
+			}
+
+			marks[state->id] = id + 1;
+
+			if(is_split_state(state) == 1){
+				if(state->next != NULL){
+					stack[stack_top] = state->next;
+					stack_top++;
+				}
+
+				if(state->next_opt != NULL){
+					stack[stack_top] = state->next_opt;
+					stack_top++;
+				}
+			} else if(state->opt == ACCEPTING){
+				glushkov->last |= (u_int64_t)1 << from;
+			} else {
+				follow[from] |= (u_int64_t)1 << positions[state->id];
+			}
+		}
+	}
+
+	//Every byte of a set gets its own table, so that follow(D) is just one lookup per byte of D
+	for(u_int32_t k = 0; k < glushkov->num_follow_tables; k++){
+		for(u_int16_t byte = 0; byte < 256; byte++){
+			for(u_int32_t bit = 0; bit < 8 && 8 * k + bit <= num_positions; bit++){
+				if((byte & (1 << bit)) != 0){
+					glushkov->follow[k][byte] |= follow[8 * k + bit];
+				}
+			}
+		}
+	}
+
+	for(u_int32_t id = 0; id < num_nfa_states; id++){
+		if(by_id[id]->opt == ACCEPTING || is_split_state(by_id[id]) == 1){
+			continue;
+		}
+
+		for(u_int16_t ch = 0; ch < 256; ch++){
+			if(opt_accepts_char(by_id[id]->opt, ch) == 1){
+				glushkov->accepts[ch] |= (u_int64_t)1 << positions[id];
+			}
+		}
+	}
+
+	free(follow);
+	free(marks);
+	free(stack);
+	free(positions);
+	free(by_id);
+
+	return glushkov;
+}
+
+
+/**
+ * Free a position automaton
+ */
+static void destroy_glushkov(glushkov_t* glushkov){
+	if(glushkov == NULL){
+		return;
+	}
+
+	free(glushkov->follow);
+	free(glushkov);
+}
+
+
+/**
+ * Every state that can come right after any of the ones in "states"
+ */
+static inline u_int64_t glushkov_follow(glushkov_t* glushkov, u_int64_t states){
+	u_int64_t next = 0;
+
+	for(u_int32_t k = 0; k < glushkov->num_follow_tables; k++){
+		next |= glushkov->follow[k][(states >> (8 * k)) & 0xFF];
+	}
+
+	return next;
+}
+
+
+/**
+ * Find a match with the position automaton. This works just like pike_match, except that all of the threads that started at the
+ * same place are one set of bits, so a whole group is stepped at once. Groups are kept in the order that they started, and a state
+ * that an earlier group is already in is taken out of every later one, which means that every group other than the newest has a
+ * position of its own, and there are never more than GLUSHKOV_MAX_POSITIONS + 1 of them. That's small enough to keep on the stack,
+ * so nothing is allocated. Only simulate_NFA should call this, since it does all of the checks that come first
+ */
+static void glushkov_match(regex_match_t* match, regex_t* regex, const char* buffer, size_t length, size_t starting_index, u_int8_t full, regex_mode_t mode){
+	glushkov_t* glushkov = (glushkov_t*)(regex->glushkov);
+	//Full matches and ^ can only start at the very beginning
+	u_int8_t anchored = full == 1 || regex->anchored_start == 1;
+	//Earliest searches stop as soon as they've found something
+	u_int8_t earliest = full == 0 && (regex->flags & REGEX_EARLIEST) != 0;
+	//We can only skip ahead if we know what a match starts with
+	u_int8_t can_skip = anchored == 0 && (regex->literal_prefix != NULL || regex->start_set != NULL);
+	u_int8_t found = 0;
+	size_t best_start = starting_index;
+	size_t best_end = starting_index;
+	//Each group's states, and where it started
+	u_int64_t states[GLUSHKOV_MAX_POSITIONS + 1];
+	size_t starts[GLUSHKOV_MAX_POSITIONS + 1];
+	u_int32_t num_groups = 0;
+	u_int32_t kept;
+	u_int64_t next;
+	u_int64_t seen;
+
+	for(size_t current_index = starting_index; ; current_index++){
+		//Nothing that starts after a match that we've already found can beat it, so we only start new groups until then
+		if(found == 0 && (anchored == 0 || current_index == starting_index)){
+			//If nothing is running, we can jump straight to the next place that a match could start
+			if(can_skip == 1 && num_groups == 0){
+				const char* candidate = find_match_candidate(regex, buffer + current_index, length - current_index);
+
+				if(candidate == NULL){
+					break;
+				}
+
+				current_index = candidate - buffer;
+			}
+
+			states[num_groups] = glushkov->initial;
+			starts[num_groups] = current_index;
+			num_groups++;
+		}
+
+		//The groups are in the order that they started, so the first one that accepts has the leftmost start
+		for(u_int32_t i = 0; i < num_groups; i++){
+			if((states[i] & glushkov->last) == 0){
+				continue;
+			}
+
+			if((full == 0 || current_index == length) && (found == 0 || starts[i] <= best_start)){
+				found = 1;
+				best_start = starts[i];
+				best_end = current_index;
+
+				if(mode == REGEX_VERBOSE){
+					printf("Accepting at index %zu for a match that started at %zu\n", current_index, best_start);
+				}
+			}
+
+			break;
+		}
+
+		//Once we're out of input or groups, we're done
+		if(current_index >= length || (earliest == 1 && found == 1) || (num_groups == 0 && (found == 1 || anchored == 1))){
+			break;
+		}
+
+		u_int64_t accepts = glushkov->accepts[(u_int8_t)buffer[current_index]];
+		seen = 0;
+		kept = 0;
+
+		//Step every group over this byte, in order, so that earlier groups get first claim on every state
+		for(u_int32_t i = 0; i < num_groups; i++){
+			//This can't beat the match that we've got
+			if(found == 1 && starts[i] > best_start){
+				break;
+			}
+
+			next = glushkov_follow(glushkov, states[i]) & accepts & ~seen;
+			seen |= next;
+
+			//Groups with nothing left are dropped
+			if(next != 0){
+				states[kept] = next;
+				starts[kept] = starts[i];
+				kept++;
+			}
+		}
+
+		num_groups = kept;
+	}
+
+	if(found == 1){
+		match->match_start_idx = best_start;
+		match->match_end_idx = best_end;
+		match->status = MATCH_FOUND;
+
+		if(mode == REGEX_VERBOSE){
+			printf("Match found!\n");
+		}
+	}
+}
+
+
+/**
+ * Find a match without the DFAs. Patterns that fit in a word use the position automaton, and everything else uses the Pike VM.
+ * Both of them find the exact same matches as the DFAs do
+ */
+static void simulate_NFA(regex_match_t* match, regex_t* regex, const char* buffer, size_t length, size_t starting_index, u_int8_t full, regex_mode_t mode){
+	//By default, we haven't found anything
+	match->status = MATCH_NOT_FOUND;
+	match->match_start_idx = starting_index;
+	match->match_end_idx = starting_index;
+
+	//An anchored match can only begin at the very start
+	if((full == 1 || regex->anchored_start == 1) && starting_index > 0){
+		return;
+	}
+
+	//If the buffer doesn't have anything that a match needs, we don't need to run anything at all
+	if(full == 0 && regex->required_factors != NULL && contains_required_factor((required_factors_t*)(regex->required_factors), buffer + starting_index, length - starting_index) == 0){
+		if(mode == REGEX_VERBOSE){
+			printf("No required factor found, so there is no match\n");
+		}
+
+		return;
+	}
+
+	if(regex->glushkov != NULL){
+		glushkov_match(match, regex, buffer, length, starting_index, full, mode);
+	} else {
+		pike_match(match, regex, buffer, length, starting_index, full, mode);
+	}
+}
+
+
+/* =========================================== End Bit-Parallel Methods ============================================ */
+
+
+/* =============================================== Capture Methods ================================================ */
+
+
+/**
+ * The threads of the capture VM. This is a sparse set just like pike_thread_list_t, except that every thread carries
+ * its own copy of the capture slots instead of where it started. Threads are kept in priority order
+ */
+typedef struct {
+	u_int32_t* dense;
+	u_int32_t* sparse;
+	//num_slots slots for every thread
+	size_t* slots;
+	u_int32_t length;
+} capture_thread_list_t;
+
+
+/**
+ * Build the program that finds captures. This comes from its own NFA, made from a postfix that marks where every group ends, so
+ * that it has states that save where groups start and end. None of the other NFAs ever see those states. If the pattern has no
+ * groups at all, there's nothing to capture and no program is made
+ */
+static void compile_capture_program(regex_t* regex, char* pattern){
+	char* postfix = in_to_post(pattern, 1, REGEX_SILENT);
+	regex_t capture_regex;
+
+	if(postfix == NULL){
+		return;
+	}
+
+	//Find out how many groups there are
+	for(char* cursor = postfix; *cursor != '\0'; cursor++){
+		//An escaped character is never a marker
+		if(*cursor == '\\'){
+			cursor++;
+		} else if(*cursor == CAPTURE_GROUP){
+			cursor++;
+
+			if((u_int32_t)(*cursor) > regex->num_groups){
+				regex->num_groups = *cursor;
+			}
+		}
+	}
+
+	if(regex->num_groups == 0){
+		free(postfix);
+		return;
+	}
+
+	memset(&capture_regex, 0, sizeof(regex_t));
+	create_NFA(&capture_regex, postfix, REGEX_SILENT);
+
+	//The groups have to match the same way that the regex does
+	if((regex->flags & REGEX_ICASE) != 0){
+		fold_NFA_case((NFA_state_t*)(capture_regex.creation_chain));
+	}
+
+	if(capture_regex.NFA != NULL){
+		regex->capture_program = compile_pike_program(&capture_regex, number_NFA_states(capture_regex.creation_chain, 0));
+	} else {
+		regex->num_groups = 0;
+	}
+
+	//The program is all that we need
+	teardown_NFA((NFA_state_t*)(capture_regex.creation_chain));
+	free(postfix);
+}
+
+
+/**
+ * Add a thread at "pc" with the capture slots in "slots", along with everything that it leads to without consuming anything. This is
+ * done depth first in priority order: alternation prefers its left side, and repetition prefers to keep going, so the threads end up
+ * in the order that a backtracking matcher would try them. Save states write "position" into their slot for everything after them,
+ * and put the old value back once we're done. If an instruction is already in the list, a thread with higher priority got there first
+ */
+static void add_capture_thread(pike_program_t* program, capture_thread_list_t* list, u_int32_t pc, size_t* slots, u_int32_t num_slots, size_t position){
+	if(pc == PIKE_NO_TARGET || (list->sparse[pc] < list->length && list->dense[list->sparse[pc]] == pc)){
+		return;
+	}
+
+	pike_instruction_t* instruction = &(program->instructions[pc]);
+	u_int32_t index = list->length;
+
+	list->sparse[pc] = index;
+	list->dense[index] = pc;
+	list->length++;
+
+	//Save where we are, then put back whatever was there
+	if(instruction->opt >= SAVE_SLOT){
+		size_t saved = slots[instruction->opt - SAVE_SLOT];
+
+		slots[instruction->opt - SAVE_SLOT] = position;
+		add_capture_thread(program, list, instruction->next, slots, num_slots, position);
+		slots[instruction->opt - SAVE_SLOT] = saved;
+
+		return;
+	}
+
+	switch(instruction->opt){
+		//The left side of an alternation comes first
+		case SPLIT_ALTERNATE:
+			add_capture_thread(program, list, instruction->next, slots, num_slots, position);
+			add_capture_thread(program, list, instruction->next_opt, slots, num_slots, position);
+			break;
+
+		//Every kind of repetition points next_opt at the part being repeated, and we'd rather repeat it
+		case SPLIT_KLEENE:
+		case SPLIT_POSITIVE_CLOSURE:
+		case SPLIT_ZERO_OR_ONE:
+			add_capture_thread(program, list, instruction->next_opt, slots, num_slots, position);
+			add_capture_thread(program, list, instruction->next, slots, num_slots, position);
+			break;
+
+		//Anything that consumes, or the accepting state, keeps its own copy of the slots
+		default:
+			memcpy(list->slots + (size_t)index * num_slots, slots, num_slots * sizeof(size_t));
+			break;
+	}
+}
+
+
+/**
+ * Fill in every group for a match that we already know the span of. The capture VM is run over just the match, anchored at its start,
+ * and only accepting right at its end counts. Of all the ways that the pattern could match exactly that span, we take the one that a
+ * backtracking matcher would have found first. Since nothing outside of the match is ever looked at, this costs about as much as one
+ * more pass over the match, no matter how much of the buffer it took to find it
+ */
+static void find_captures(regex_t* regex, regex_captures_t* captures, const char* buffer, size_t start, size_t end){
+	pike_program_t* program = (pike_program_t*)(regex->capture_program);
+	u_int32_t num_slots = 2 * regex->num_groups;
+	capture_thread_list_t lists[2];
+	capture_thread_list_t* current = &(lists[0]);
+	capture_thread_list_t* next = &(lists[1]);
+	capture_thread_list_t* swap;
+	pike_instruction_t* instruction;
+	size_t* slots = malloc(num_slots * sizeof(size_t));
+
+	for(u_int8_t i = 0; i < 2; i++){
+		lists[i].dense = malloc(program->num_instructions * sizeof(u_int32_t));
+		lists[i].sparse = calloc(program->num_instructions, sizeof(u_int32_t));
+		lists[i].slots = malloc((size_t)(program->num_instructions) * num_slots * sizeof(size_t));
+		lists[i].length = 0;
+	}
+
+	//Nothing has been captured yet
+	for(u_int32_t i = 0; i < num_slots; i++){
+		slots[i] = REGEX_NO_GROUP;
+	}
+
+	add_capture_thread(program, current, program->start, slots, num_slots, start);
+
+	for(size_t current_index = start; current->length > 0; current_index++){
+		next->length = 0;
+
+		for(u_int32_t i = 0; i < current->length; i++){
+			instruction = &(program->instructions[current->dense[i]]);
+
+			//Only the end of the match counts, and once something gets there, nothing after it in the list can beat it
+			if(instruction->opt == ACCEPTING){
+				if(current_index == end){
+					for(u_int32_t group = 0; group < regex->num_groups; group++){
+						captures->groups[group + 1].start = current->slots[(size_t)i * num_slots + 2 * group];
+						captures->groups[group + 1].end = current->slots[(size_t)i * num_slots + 2 * group + 1];
+					}
+
+					break;
+				}
+
+				continue;
+			}
+
+			if(current_index < end && opt_accepts_char(instruction->opt, (u_int8_t)buffer[current_index]) == 1){
+				add_capture_thread(program, next, instruction->next, current->slots + (size_t)i * num_slots, num_slots, current_index + 1);
+			}
+		}
+
+		//There's nothing left to read
+		if(current_index == end){
+			break;
+		}
+
+		swap = current;
+		current = next;
+		next = swap;
+	}
+
+	free(slots);
+
+	for(u_int8_t i = 0; i < 2; i++){
+		free(lists[i].dense);
+		free(lists[i].sparse);
+		free(lists[i].slots);
+	}
+}
+
+
+/* ============================================= End Capture Methods ============================================== */
+
+
+/**
+ * Find the literal prefix that every match of the regex has to start with. We simply follow the NFA from its
+ * start state for as long as we keep seeing plain characters. The moment that we see a split, a range, a wildcard
+ * or the accepting state, we can't be sure what comes next, so the prefix ends there
+ */
+static void extract_literal_prefix(regex_t* regex){
+	char prefix[REGEX_LEN];
+	u_int32_t length = 0;
+
+	//Follow the chain of plain characters. A chain like this can never loop back on itself without a split
+	for(NFA_state_t* cursor = regex->NFA; cursor != NULL && length < REGEX_LEN - 1; cursor = cursor->next){
+		//Anything that isn't a plain printable character ends the prefix
+		if(cursor->opt < 32 || cursor->opt > 126){
+			break;
+		}
+
+		prefix[length] = (char)(cursor->opt);
+		length++;
+	}
+
+	regex->literal_prefix_length = length;
+
+	//If we found nothing, there's nothing to save
+	if(length == 0){
+		regex->literal_prefix = NULL;
+		return;
+	}
+
+	//Save it as a null terminated string so that it can be used with both strstr and memmem
+	regex->literal_prefix = calloc(length + 1, sizeof(char));
+	memcpy(regex->literal_prefix, prefix, length);
+}
+
+
+/**
+ * Find every byte that the anchored DFA's start state has a transition on. Outside of a match, every other byte just sends us right back
+ * to the start state, so the match functions can skip over them without touching the DFA at all. If the start state can accept
+ * on its own, or the set is so big that skipping wouldn't buy us anything, no start set is made
+ */
+static void compute_start_set(regex_t* regex){
+	transition_table_t* table = (transition_table_t*)(regex->anchored_table);
+	regex->start_set = NULL;
+
+	//If we can accept without seeing anything, every position could be a match
+	if((table_start(table) & TRANSITION_ACCEPTING) != 0){
+		return;
+	}
+
+	start_set_t* set = calloc(1, sizeof(start_set_t));
+
+	//Grab every byte that we can leave the start state on. If the table is lazy and it gets flushed along the way, the start
+	//state is still in row 0
+	for(u_int16_t ch = 1; ch < 128; ch++){
+		if((table_transition(table, 0, ch) & TRANSITION_DEAD) == 0){
+			set->member[ch] = 1;
+			set->bytes[set->num_bytes] = (char)ch;
+			set->num_bytes++;
+		}
+	}
+
+	//If this set is empty or too big, it isn't worth it
+	if(set->num_bytes == 0 || set->num_bytes > START_SET_MAX_BYTES){
+		free(set);
+		return;
+	}
+
+	//Now break the set up into ranges of consecutive bytes
+	for(u_int16_t ch = 1; ch < 128; ch++){
+		//Only look at the start of each range
+		if(set->member[ch] == 0 || set->member[ch - 1] == 1){
+			continue;
+		}
+
+		//Too many ranges to vectorize
+		if(set->num_ranges == START_SET_MAX_RANGES){
+			set->num_ranges = 0;
+			break;
+		}
+
+		//Find where it ends
+		u_int16_t end = ch;
+		while(end + 1 < 128 && set->member[end + 1] == 1){
+			end++;
+		}
+
+		set->range_low[set->num_ranges] = ch;
+		set->range_high[set->num_ranges] = end;
+		set->num_ranges++;
+	}
+
+	regex->start_set = set;
+}
+
+
+/**
+ * How useful a set of required factors is. A set is only as good as its shortest string, since that's the
+ * one that is most likely to show up by chance. A set with the empty string in it tells us nothing at all
+ */
+static u_int32_t factor_set_score(factor_set_t* set){
+	if(set->valid == 0 || set->count == 0){
+		return 0;
+	}
+
+	u_int32_t shortest = REQUIRED_FACTOR_MAX_LENGTH;
+	for(u_int8_t i = 0; i < set->count; i++){
+		if(set->lengths[i] < shortest){
+			shortest = set->lengths[i];
+		}
+	}
+
+	return shortest;
+}
+
+
+/**
+ * Keep whichever of the two factor sets is more useful in "best". Ties go to the set with fewer strings in it
+ */
+static void keep_better_factor_set(factor_set_t* best, factor_set_t* candidate){
+	u_int32_t best_score = factor_set_score(best);
+	u_int32_t candidate_score = factor_set_score(candidate);
+
+	if(candidate_score > best_score || (candidate_score == best_score && candidate_score > 0 && candidate->count < best->count)){
+		*best = *candidate;
+	}
+}
+
+
+/**
+ * Add a string to a factor set. If there isn't any room for it, the set becomes invalid
+ */
+static void add_to_factor_set(factor_set_t* set, const char* string, u_int32_t length){
+	if(set->valid == 0){
+		return;
+	}
+
+	//No need to have it twice
+	for(u_int8_t i = 0; i < set->count; i++){
+		if(set->lengths[i] == length && memcmp(set->strings[i], string, length) == 0){
+			return;
+		}
+	}
+
+	if(set->count == REQUIRED_FACTOR_MAX_ALTERNATIVES || length > REQUIRED_FACTOR_MAX_LENGTH){
+		set->valid = 0;
+		return;
+	}
+
+	memcpy(set->strings[set->count], string, length);
+	set->strings[set->count][length] = '\0';
+	set->lengths[set->count] = length;
+	set->count++;
+}
+
+
+/**
+ * Add every string in "source" to "set"
+ */
+static void union_factor_sets(factor_set_t* set, factor_set_t* source){
+	if(source->valid == 0){
+		set->valid = 0;
+		return;
+	}
+
+	for(u_int8_t i = 0; set->valid == 1 && i < source->count; i++){
+		add_to_factor_set(set, source->strings[i], source->lengths[i]);
+	}
+}
+
+
+/**
+ * Make "result" every string in "first" followed by every string in "second". Joined strings that are too long either make
+ * the result invalid(FACTOR_KEEP_NONE), or get cut down to their first(FACTOR_KEEP_FRONT) or last(FACTOR_KEEP_BACK)
+ * REQUIRED_FACTOR_MAX_LENGTH bytes. Cutting is fine for prefixes, suffixes and required factors, since any piece of a
+ * string that has to be there also has to be there
+ */
+typedef enum {
+	FACTOR_KEEP_NONE,
+	FACTOR_KEEP_FRONT,
+	FACTOR_KEEP_BACK,
+} factor_keep_t;
+
+static void cross_factor_sets(factor_set_t* result, factor_set_t* first, factor_set_t* second, factor_keep_t keep){
+	char joined[2 * REQUIRED_FACTOR_MAX_LENGTH];
+	u_int32_t length;
+
+	memset(result, 0, sizeof(factor_set_t));
+	result->valid = first->valid && second->valid;
+
+	for(u_int8_t i = 0; result->valid == 1 && i < first->count; i++){
+		for(u_int8_t j = 0; result->valid == 1 && j < second->count; j++){
+			memcpy(joined, first->strings[i], first->lengths[i]);
+			memcpy(joined + first->lengths[i], second->strings[j], second->lengths[j]);
+			length = first->lengths[i] + second->lengths[j];
+
+			if(length > REQUIRED_FACTOR_MAX_LENGTH && keep == FACTOR_KEEP_FRONT){
+				length = REQUIRED_FACTOR_MAX_LENGTH;
+			} else if(length > REQUIRED_FACTOR_MAX_LENGTH && keep == FACTOR_KEEP_BACK){
+				add_to_factor_set(result, joined + length - REQUIRED_FACTOR_MAX_LENGTH, REQUIRED_FACTOR_MAX_LENGTH);
+				continue;
+			}
+
+			add_to_factor_set(result, joined, length);
+		}
+	}
+}
+
+
+/**
+ * Walk the postfix form of the regex, which is the exact same walk that create_NFA does, and figure out what literal
+ * strings every match has to contain. For every piece of the regex we keep track of:
+ *
+ * 	exact - every string that the piece can match, if there are only a few of them
+ * 	prefix - strings that everything the piece matches starts with one of
+ * 	suffix - strings that everything the piece matches ends with one of
+ * 	required - strings that everything the piece matches contains at least one of
+ *
+ * Characters match exactly themselves, and ranges or wildcards could be anything. Concatenation glues the first
+ * piece's strings onto the second's, and a match also has to contain one of the first piece's suffixes followed by
+ * one of the second piece's prefixes. Alternation takes the strings of both sides. 0 or 1 adds the empty string,
+ * 1 or more keeps everything but the exact set, and the kleene star could be anything.
+ *
+ * At the end, if the whole regex needs one of a few literal strings, the match functions can search for those first
+ * and skip the DFA entirely when none of them are there
+ */
+static void extract_required_factors(regex_t* regex){
+	regex->required_factors = NULL;
+
+	//One entry for every piece that could be on the stack at once
+	factor_info_t* stack = calloc(strlen(regex->regex) + 1, sizeof(factor_info_t));
+	u_int32_t top = 0;
+	factor_info_t* first;
+	factor_info_t* second;
+	factor_info_t combined;
+	factor_set_t across;
+	char ch;
+
+	for(char* cursor = regex->regex; *cursor != '\0'; cursor++){
+		ch = *cursor;
+
+		//If an operator doesn't have what it needs, the regex is bad and there's nothing to learn from it
+		if((ch == '`' || ch == '|') ? top < 2 : ((ch == '?' || ch == '*' || ch == '+') && top < 1)){
+			free(stack);
+			return;
+		}
+
+		switch(ch){
+			//Concatenation
+			case '`':
+				first = &(stack[top - 2]);
+				second = &(stack[top - 1]);
+
+				//Every string from the first piece followed by every string from the second
+				cross_factor_sets(&(combined.exact), &(first->exact), &(second->exact), FACTOR_KEEP_NONE);
+
+				//If we know exactly what the first piece matches, it goes in front of the second piece's prefixes
+				if(first->exact.valid == 1){
+					cross_factor_sets(&(combined.prefix), &(first->exact), &(second->prefix), FACTOR_KEEP_FRONT);
+					keep_better_factor_set(&(combined.prefix), &(first->exact));
+				} else {
+					combined.prefix = first->prefix;
+				}
+
+				//And the same goes for the end
+				if(second->exact.valid == 1){
+					cross_factor_sets(&(combined.suffix), &(first->suffix), &(second->exact), FACTOR_KEEP_BACK);
+					keep_better_factor_set(&(combined.suffix), &(second->exact));
+				} else {
+					combined.suffix = second->suffix;
+				}
+
+				//Whatever either side needed is still needed, and so is whatever is found where they meet
+				combined.required = first->required;
+				keep_better_factor_set(&(combined.required), &(second->required));
+				cross_factor_sets(&across, &(first->suffix), &(second->prefix), FACTOR_KEEP_FRONT);
+				keep_better_factor_set(&(combined.required), &across);
+				keep_better_factor_set(&(combined.required), &(combined.exact));
+
+				top--;
+				stack[top - 1] = combined;
+				break;
+
+			//Alternation
+			case '|':
+				first = &(stack[top - 2]);
+				second = &(stack[top - 1]);
+				combined = *first;
+
+				//Everything comes from either side
+				union_factor_sets(&(combined.exact), &(second->exact));
+				union_factor_sets(&(combined.prefix), &(second->prefix));
+				union_factor_sets(&(combined.suffix), &(second->suffix));
+
+				//We need one of the things that either side needed. If a side didn't need anything, neither do we
+				if(factor_set_score(&(first->required)) == 0 || factor_set_score(&(second->required)) == 0){
+					combined.required.valid = 0;
+				}
+				union_factor_sets(&(combined.required), &(second->required));
+				keep_better_factor_set(&(combined.required), &(combined.exact));
+
+				top--;
+				stack[top - 1] = combined;
+				break;
+
+			//0 or 1 adds the empty string, and we can't count on anything being there
+			case '?':
+				add_to_factor_set(&(stack[top - 1].exact), "", 0);
+				stack[top - 1].prefix = stack[top - 1].exact;
+				stack[top - 1].suffix = stack[top - 1].exact;
+				stack[top - 1].required.valid = 0;
+				break;
+
+			//0 or more could be anything
+			case '*':
+				memset(&(stack[top - 1]), 0, sizeof(factor_info_t));
+				break;
+
+			//1 or more still starts, ends and contains what the piece did, but we no longer know exactly what it matches
+			case '+':
+				stack[top - 1].exact.valid = 0;
+				break;
+
+			//Ranges and wildcards could be anything. The ranges have the same shape that create_NFA expects
+			case '[':
+			case '$':
+				if(ch == '['){
+					cursor += (*(cursor + 1) == 'a' && *(cursor + 4) == 'A') ? 7 : 4;
+				}
+
+				memset(&(stack[top]), 0, sizeof(factor_info_t));
+				top++;
+				break;
+
+			//An escaped character is just the character itself
+			case '\\':
+				cursor++;
+				//Fall through
+
+			default:
+				memset(&(stack[top]), 0, sizeof(factor_info_t));
+
+				//A letter that could be either case is no more use to us than a range
+				if((regex->flags & REGEX_ICASE) != 0 && ((*cursor >= 'a' && *cursor <= 'z') || (*cursor >= 'A' && *cursor <= 'Z'))){
+					top++;
+					break;
+				}
+
+				stack[top].exact.valid = 1;
+				add_to_factor_set(&(stack[top].exact), cursor, 1);
+				stack[top].prefix = stack[top].exact;
+				stack[top].suffix = stack[top].exact;
+				stack[top].required = stack[top].exact;
+				top++;
+				break;
+		}
+	}
+
+	factor_set_t* best = &(stack[0].required);
+
+	//If we didn't find anything worth searching for, we're done
+	if(top != 1 || factor_set_score(best) == 0){
+		free(stack);
+		return;
+	}
+
+	//If the only factor is already a part of the literal prefix, the prefix search is already doing this for us
+	if(best->count == 1 && regex->literal_prefix != NULL && strstr(regex->literal_prefix, best->strings[0]) != NULL){
+		free(stack);
+		return;
+	}
+
+	required_factors_t* factors = calloc(1, sizeof(required_factors_t));
+	factors->num_factors = best->count;
+	factors->min_length = factor_set_score(best);
+
+	for(u_int8_t i = 0; i < best->count; i++){
+		factors->lengths[i] = best->lengths[i];
+		factors->factors[i] = calloc(best->lengths[i] + 1, sizeof(char));
+		memcpy(factors->factors[i], best->strings[i], best->lengths[i]);
+	}
+
+	//Build the Horspool shift table over the first min_length bytes of every factor. By default, a byte that doesn't show
+	//up in any of them lets us slide the window all the way past it
+	for(u_int16_t c = 0; c < 256; c++){
+		factors->shift[c] = factors->min_length;
+	}
+
+	for(u_int32_t i = 0; i < factors->num_factors; i++){
+		for(u_int32_t j = 0; j + 1 < factors->min_length; j++){
+			u_int32_t distance = factors->min_length - 1 - j;
+			u_int8_t c = (u_int8_t)(factors->factors[i][j]);
+
+			if(distance < factors->shift[c]){
+				factors->shift[c] = distance;
+			}
+		}
+	}
+
+	regex->required_factors = factors;
+	free(stack);
+}
+
+
+/**
+ * Find out if the buffer contains any of the regex's required factors. A single factor is found with memchr or memmem(which
+ * is a two-way search in glibc). Several factors are all searched for at once with Horspool's algorithm: we slide a window
+ * as wide as the shortest factor along the buffer, and the byte at the end of the window tells us how far we can slide it
+ * without skipping over the start of any factor. Returns 1 if one of them is in there, 0 if none of them are
+ */
+static u_int8_t contains_required_factor(required_factors_t* factors, const char* buffer, size_t length){
+	//Just one factor
+	if(factors->num_factors == 1){
+		if(factors->lengths[0] == 1){
+			return memchr(buffer, factors->factors[0][0], length) != NULL;
+		}
+
+		return memmem(buffer, length, factors->factors[0], factors->lengths[0]) != NULL;
+	}
+
+	size_t window = factors->min_length;
+
+	for(size_t position = 0; position + window <= length; position += factors->shift[(u_int8_t)buffer[position + window - 1]]){
+		//See if any of the factors start right here
+		for(u_int32_t i = 0; i < factors->num_factors; i++){
+			if(position + factors->lengths[i] <= length && memcmp(buffer + position, factors->factors[i], factors->lengths[i]) == 0){
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * Build an NFA and then DFA for a regular expression defined by the pattern
+ * passed in.
+ *
+ * If anything goes wrong, a regex_t struct will be returned in a REGEX_ERR state. This regex
+ * will then be useless by the match function
+ */
+regex_t* define_regular_expression(char* pattern, regex_mode_t mode){
+	return define_regular_expression_flags(pattern, mode, REGEX_LEFTMOST_LONGEST);
+}
+
+
+/**
+ * Build an NFA and then all of the DFAs for a regular expression, using the compile flags that
+ * were passed in
+ */
+regex_t* define_regular_expression_flags(char* pattern, regex_mode_t mode, u_int32_t flags){
+	//Stack allocate a regex
+	regex_t* regex = calloc(1, sizeof(regex_t));
+	//Set to NULL as a flag
+	regex->NFA = NULL;
+	regex->creation_chain = NULL;
+	regex->anchored_DFA = NULL;
+	regex->forward_DFA = NULL;
+	regex->reverse_DFA = NULL;
+	regex->program = NULL;
+	regex->glushkov = NULL;
+	regex->capture_program = NULL;
+	regex->num_groups = 0;
+	regex->flags = flags;
+
+	//A leading ^ anchors every match to the very start of the input. It isn't part of the pattern itself
+	if(pattern != NULL && pattern[0] == '^'){
+		regex->anchored_start = 1;
+		pattern++;
+	}
+
+	//Just in case
+	if(pattern == NULL || strlen(pattern) == 0){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Pattern cannot be null or empty\n");
+		}
+
+		//Set this flag so that the user knows
+		regex->state = REGEX_ERR;
+		return regex;
+	}
+
+	//Set a hard limit. I don't see a situation where we'd need more than 150 characters for a regex
+	if(strlen(pattern) >= REGEX_LEN){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Patterns of size 150 or more not supported\n");
+		}
+
+		regex->state = REGEX_ERR;
+		return regex;
+	}
+
+	//Convert to postfix before applying our algorithm
+	char* postfix = in_to_post(pattern, 0, mode);
+	//Save for reference
+	regex->regex = postfix;
+
+	//If this didn't work, we will stop and return a bad regex
+	if(postfix == NULL){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Postfix conversion failed.\n");
+		}
+
+		//Put in error state
+		regex->state = REGEX_ERR;
+		return regex;
+	}
+
+	//Show postfix if it exists
+	if(mode == REGEX_VERBOSE){
+		printf("Postfix conversion: %s\n", postfix);
+	}
+
+	//Create the NFA first
+	 create_NFA(regex, postfix, mode);
+
+	//If this is bad, we'll bail out here
+	if(regex->NFA == NULL){
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: NFA creation failed.\n");
+		}
+
+		//Ensure there is no leakage. The postfix is freed along with the regex
+		teardown_NFA((NFA_state_t*)(regex->creation_chain));
+		regex->creation_chain = NULL;
+
+		//Put in error state
+		regex->state = REGEX_ERR;
+		return regex;
+	}
+
+	//Letters match either case from here on out
+	if((regex->flags & REGEX_ICASE) != 0){
+		fold_NFA_case((NFA_state_t*)(regex->creation_chain));
+	}
+
+	//Find out what every match has to start with, so that the match functions can skip right to it
+	extract_literal_prefix(regex);
+
+	//Find out what every match has to contain, so that the match functions can give up early when it isn't there
+	if(regex->NFA != NULL){
+		extract_required_factors(regex);
+	}
+
+	//Display if desired
+	if(mode == REGEX_VERBOSE){
+		printf("\nNFA conversion succeeded.\n");
+		print_NFA(regex->NFA);
+
+		if(regex->literal_prefix != NULL){
+			printf("\nLiteral prefix: %s", regex->literal_prefix);
+		}
+
+		if(regex->required_factors != NULL){
+			required_factors_t* factors = (required_factors_t*)(regex->required_factors);
+
+			printf("\nRequired factors:");
+			for(u_int32_t i = 0; i < factors->num_factors; i++){
+				printf(" %s", factors->factors[i]);
+			}
+		}
+
+		printf("\n\nBeginning DFA Conversion.\n\n");
+	}
+
+	//Now we'll use the NFA to create the DFAs. We'll do this because DFA's are much more
+	//efficient to simulate since they are determinsitic, but they are much harder to create
+	//from regular expressions
+	u_int32_t num_nfa_states = number_NFA_states(regex->creation_chain, 0);
+
+	//The Pike VM program is tiny and can match anything, so every regex gets one to fall back on. Patterns that are short enough
+	//also get a position automaton, which does the same job a word at a time
+	regex->program = compile_pike_program(regex, num_nfa_states);
+	regex->glushkov = compile_glushkov(regex, num_nfa_states);
+
+	//Groups are captured with a program of their own
+	compile_capture_program(regex, pattern);
+
+	//If we were asked to only simulate the NFA, there's nothing more to build
+	if((regex->flags & REGEX_NFA) != 0){
+		if(mode == REGEX_VERBOSE){
+			printf("Skipping DFA conversion, matches will be found by simulating the NFA.\n");
+		}
+
+		regex->state = REGEX_VALID;
+		return regex;
+	}
+
+	//The anchored DFA never goes back to the start, so it's what we use for ^ and full matches
+	regex->anchored_table = build_regex_DFA(regex, DFA_ANCHORED, num_nfa_states, &(regex->anchored_DFA), mode);
+
+	//The forward DFA finds where matches end. Which one we build depends on the match semantics that were asked for
+	if(regex->anchored_table != NULL){
+		regex->forward_table = build_regex_DFA(regex, DFA_FORWARD, num_nfa_states, &(regex->forward_DFA), mode);
+	}
+
+	//The reverse DFA reads backwards from where a match ends to find where it starts
+	if(regex->forward_table != NULL){
+		regex->reverse_table = build_regex_DFA(regex, DFA_REVERSE, num_nfa_states, &(regex->reverse_DFA), mode);
+	}
+
+	//If any of them can't be built, we'll simulate the NFA instead
+	if(regex->anchored_table == NULL || regex->forward_table == NULL || regex->reverse_table == NULL){
+		if(mode == REGEX_VERBOSE){
+			printf("DFA creation failed, matches will be found by simulating the NFA.\n");
+		}
+
+		teardown_DFA((DFA_state_t*)(regex->anchored_DFA));
+		teardown_DFA((DFA_state_t*)(regex->forward_DFA));
+		teardown_DFA((DFA_state_t*)(regex->reverse_DFA));
+		destroy_transition_table((transition_table_t*)(regex->anchored_table));
+		destroy_transition_table((transition_table_t*)(regex->forward_table));
+		destroy_transition_table((transition_table_t*)(regex->reverse_table));
+		regex->anchored_DFA = NULL;
+		regex->forward_DFA = NULL;
+		regex->reverse_DFA = NULL;
+		regex->anchored_table = NULL;
+		regex->forward_table = NULL;
+		regex->reverse_table = NULL;
+		regex->flags |= REGEX_NFA;
+		regex->state = REGEX_VALID;
+		return regex;
+	}
+
+	//An anchored match can't skip ahead, so the prefix is of no use to it
+	if(regex->anchored_start == 1){
+		free(regex->literal_prefix);
+		regex->literal_prefix = NULL;
+		regex->literal_prefix_length = 0;
+
+	//If there's no literal prefix, we can still skip over bytes that can never start a match
+	} else if(regex->literal_prefix == NULL){
+		compute_start_set(regex);
+	}
+
+	//If we can skip ahead, the forward DFA needs to say when it's back in its start state
+	if(regex->literal_prefix != NULL || regex->start_set != NULL){
+		enable_start_skipping((transition_table_t*)(regex->forward_table));
+	}
+
+	//Display if desired
+	if(mode == REGEX_VERBOSE){
+		printf("DFA conversion succeeded.\n");
+
+		if(regex->start_set != NULL){
+			printf("Start byte set: %s\n", ((start_set_t*)(regex->start_set))->bytes);
+		}
+	}
+
+	//If it did work, we'll set everything to true
+	regex->state = REGEX_VALID;
+
+	//If the user request verbose mode, we'll display
+	if(mode == REGEX_VERBOSE){
+		printf("regex_t creation succeeded. Regex is now ready to be used.\n");
+	}
+
+	//If we make it here, we did a valid postfix, NFA and then NFA->DFA conversion, so
+	//the regex is all set
+	return regex;
+}
+
+
+/**
+ * Run the anchored DFA from the very start of the buffer. There is no resetting here: the moment that we hit a byte with
+ * no transition, no match that starts at the beginning can go any further, so we stop right there. For a search, the match
+ * is the longest one that we saw along the way(or the first one for earliest matches). For a full match, we have to have used up every byte and be accepting.
+ * Null terminated strings can be passed in with a length of SIZE_MAX, because nothing ever has a transition on '\0'
+ */
+static void anchored_match(regex_match_t* match, regex_t* regex, const char* buffer, size_t length, size_t starting_index, u_int8_t full, regex_mode_t mode){
+	//By default, we haven't found anything
+	match->status = MATCH_NOT_FOUND;
+	match->match_start_idx = starting_index;
+	match->match_end_idx = starting_index;
+
+	//An anchored match can only begin at the very start
+	if(starting_index > 0){
+		return;
+	}
+
+	transition_table_t* table = (transition_table_t*)(regex->anchored_table);
+	u_int32_t current_state = table_start(table);
+	u_int32_t next_state;
+	//The empty string might already be a match
+	u_int8_t found = (current_state & TRANSITION_ACCEPTING) != 0;
+	//Earliest searches stop as soon as they've found something
+	u_int8_t earliest = full == 0 && (regex->flags & REGEX_EARLIEST) != 0;
+	size_t current_index;
+
+	for(current_index = 0; current_index < length && (found == 0 || earliest == 0); current_index++){
+		next_state = table_transition(table, current_state & TRANSITION_ROW_MASK, (u_int8_t)buffer[current_index]);
+
+		//Nothing that starts at the beginning can get past this byte
+		if((next_state & TRANSITION_DEAD) != 0){
+			if(mode == REGEX_VERBOSE){
+				printf("No transition at index %zu, stopping\n", current_index);
+			}
+
+			break;
+		}
+
+		current_state = next_state;
+
+		//Remember the longest match so far
+		if((current_state & TRANSITION_ACCEPTING) != 0){
+			found = 1;
+			match->match_end_idx = current_index + 1;
+		}
+	}
+
+	//A full match has to use up everything
+	if(full == 1){
+		found = current_index == length && (current_state & TRANSITION_ACCEPTING) != 0;
+	}
+
+	if(found == 1){
+		match->status = MATCH_FOUND;
+
+		if(mode == REGEX_VERBOSE){
+			printf("Match found!\n");
+		}
+
+		return;
+	}
+
+	match->match_end_idx = starting_index;
+}
+
+
+/**
+ * Find the first place in the buffer where the regex's literal prefix shows up. A single character
+ * is found with memchr, and anything longer with memmem. Both of these are far faster than stepping
+ * through the DFA one byte at a time
+ */
+static const char* find_literal_prefix(regex_t* regex, const char* buffer, size_t length){
+	if(regex->literal_prefix_length == 1){
+		return memchr(buffer, regex->literal_prefix[0], length);
+	}
+
+	return memmem(buffer, length, regex->literal_prefix, regex->literal_prefix_length);
+}
+
+
+/**
+ * Find the first byte in the buffer that belongs to the start set. A set with just one byte in it is found with memchr.
+ * Otherwise, we check 32(AVX2) or 16(SSE2) bytes at a time against every range in the set. A byte is inside of
+ * [low, high] exactly when (byte - low) <= (high - low) as an unsigned value, and a saturating subtract of (high - low)
+ * gives us 0 in exactly that case. Whatever is left over at the end is checked one byte at a time
+ */
+static const char* find_start_byte(start_set_t* set, const char* buffer, size_t length){
+	//Nothing beats memchr for one byte
+	if(set->num_bytes == 1){
+		return memchr(buffer, set->bytes[0], length);
+	}
+
+	size_t i = 0;
+
+#if defined(__AVX2__)
+	if(set->num_ranges > 0){
+		__m256i lows[START_SET_MAX_RANGES];
+		__m256i widths[START_SET_MAX_RANGES];
+		__m256i zero = _mm256_setzero_si256();
+
+		//Set up the ranges once
+		for(u_int8_t r = 0; r < set->num_ranges; r++){
+			lows[r] = _mm256_set1_epi8((char)(set->range_low[r]));
+			widths[r] = _mm256_set1_epi8((char)(set->range_high[r] - set->range_low[r]));
+		}
+
+		for(; i + 32 <= length; i += 32){
+			__m256i chunk = _mm256_loadu_si256((const __m256i*)(buffer + i));
+			__m256i hits = zero;
+
+			for(u_int8_t r = 0; r < set->num_ranges; r++){
+				__m256i offset = _mm256_subs_epu8(_mm256_sub_epi8(chunk, lows[r]), widths[r]);
+				hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(offset, zero));
+			}
+
+			u_int32_t mask = (u_int32_t)_mm256_movemask_epi8(hits);
+			if(mask != 0){
+				return buffer + i + __builtin_ctz(mask);
+			}
+		}
+	}
+#elif defined(__SSE2__)
+	if(set->num_ranges > 0){
+		__m128i lows[START_SET_MAX_RANGES];
+		__m128i widths[START_SET_MAX_RANGES];
+		__m128i zero = _mm_setzero_si128();
+
+		//Set up the ranges once
+		for(u_int8_t r = 0; r < set->num_ranges; r++){
+			lows[r] = _mm_set1_epi8((char)(set->range_low[r]));
+			widths[r] = _mm_set1_epi8((char)(set->range_high[r] - set->range_low[r]));
+		}
+
+		for(; i + 16 <= length; i += 16){
+			__m128i chunk = _mm_loadu_si128((const __m128i*)(buffer + i));
+			__m128i hits = zero;
+
+			for(u_int8_t r = 0; r < set->num_ranges; r++){
+				__m128i offset = _mm_subs_epu8(_mm_sub_epi8(chunk, lows[r]), widths[r]);
+				hits = _mm_or_si128(hits, _mm_cmpeq_epi8(offset, zero));
+			}
+
+			u_int32_t mask = (u_int32_t)_mm_movemask_epi8(hits);
+			if(mask != 0){
+				return buffer + i + __builtin_ctz(mask);
+			}
+		}
+	}
+#endif
+
+	//Whatever is left over is done one at a time
+	for(; i < length; i++){
+		if(set->member[(u_int8_t)buffer[i]] == 1){
+			return buffer + i;
+		}
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Find the next place in the buffer where a match could start, using the literal prefix if there is one and the start set
+ * otherwise. Only call this if the regex has one of them
+ */
+static const char* find_match_candidate(regex_t* regex, const char* buffer, size_t length){
+	if(regex->literal_prefix != NULL){
+		return find_literal_prefix(regex, buffer, length);
+	}
+
+	return find_start_byte((start_set_t*)(regex->start_set), buffer, length);
+}
+
+
+/**
+ * Run the forward DFA over the buffer to find where the match ends. The forward DFA is unanchored, so it never has to be
+ * reset or rescan anything. For earliest matches, we stop the moment that any match ends. For leftmost-longest matches,
+ * we keep going until the DFA dies(which happens once every match that could still beat the one we've got is gone),
+ * and the match ends at the last place that we accepted. Returns 1 and fills in "end" if there's a match.
+ *
+ * This is always inlined with "verbose" as a constant, so the compiler gives us two separate loops. The silent one never
+ * looks at the mode at all. We walk the forward transition table, so for nearly every byte all that we do is one load and
+ * one check that the state we landed in has no flags. Dying, accepting and skipping ahead from the start state are only
+ * dealt with once a flag shows up
+ */
+static inline __attribute__((always_inline)) u_int8_t forward_search_loop(regex_t* regex, u_int32_t state, const char* buffer, size_t length, size_t starting_index, size_t* end, const u_int8_t verbose){
+	transition_table_t* table = (transition_table_t*)(regex->forward_table);
+	const u_int32_t* transitions = table->transitions;
+	//Where the row of the state that we're in starts. This never has any flags in it, so on the fast path it's just added to the byte
+	size_t row = state & TRANSITION_ROW_MASK;
+	u_int8_t earliest = (regex->flags & REGEX_EARLIEST) != 0;
+	u_int8_t found = 0;
+	size_t current_index = starting_index;
+	u_int8_t ch;
+
+	//The empty string might already be a match
+	if((state & TRANSITION_ACCEPTING) != 0){
+		found = 1;
+		*end = starting_index;
+
+		if(earliest == 1){
+			return 1;
+		}
+	}
+
+	//If we're starting out in the start state, nothing can begin until we see the literal prefix or a byte in the start
+	//set, so we'll jump straight to the next place that one shows up
+	if((state & TRANSITION_START) != 0){
+		const char* candidate = find_match_candidate(regex, buffer + current_index, length - current_index);
+
+		//If it's nowhere to be found, there is no match
+		if(candidate == NULL){
+			return found;
+		}
+
+		current_index = candidate - buffer;
+
+		if(verbose == 1){
+			printf("Skipped ahead to possible match at index: %zu\n", current_index);
+		}
+	}
+
+	//Scan through exactly the bytes we were given
+	for(; current_index < length; current_index++){
+		ch = (u_int8_t)buffer[current_index];
+		state = transitions[row + ch];
+
+		//If we're in verbose mode, print this out
+		if(verbose == 1 && (state & TRANSITION_DEAD) == 0){
+			printf("Pattern continued/started with character: %c\n", ch);
+		}
+
+		//This is the common case, a state with no flags
+		if(state <= TRANSITION_ROW_MASK){
+			row = state;
+			continue;
+		}
+
+		//A lazy DFA hasn't been here before, so we'll work out where we go. The table might have moved or been flushed, but
+		//the state that we get back is always good
+		if((state & TRANSITION_UNKNOWN) != 0){
+			state = lazy_transition(table, row, ch);
+			transitions = table->transitions;
+
+			if(state <= TRANSITION_ROW_MASK){
+				row = state;
+				continue;
+			}
+		}
+
+		//If the DFA died, nothing can beat the match that we already have
+		if((state & TRANSITION_DEAD) != 0){
+			break;
+		}
+
+		row = state & TRANSITION_ROW_MASK;
+
+		//Remember where this match ends
+		if((state & TRANSITION_ACCEPTING) != 0){
+			found = 1;
+			*end = current_index + 1;
+
+			//Earliest matches are done right away
+			if(earliest == 1){
+				break;
+			}
+		}
+
+		//We're back in the start state, so we'll skip ahead to the next place that a match could begin
+		if((state & TRANSITION_START) != 0){
+			const char* candidate = find_match_candidate(regex, buffer + current_index + 1, length - current_index - 1);
+
+			if(candidate == NULL){
+				break;
+			}
+
+			//The loop steps onto the candidate
+			current_index = candidate - buffer - 1;
+
+			if(verbose == 1){
+				printf("Skipped ahead to possible match at index: %zu\n", current_index + 1);
+			}
+		}
+	}
+
+	return found;
+}
+
+
+/**
+ * Find where the match ends, picking up in the packed state "current_state", which is normally the start state. The parallel
+ * matcher uses this to carry on from the middle of the buffer once it knows what state the DFA is in there. The mode is only
+ * checked once in here, to pick which loop to run
+ */
+static u_int8_t resume_forward_search(regex_t* regex, u_int32_t current_state, const char* buffer, size_t length, size_t starting_index, size_t* end, regex_mode_t mode){
+	if(mode == REGEX_VERBOSE){
+		return forward_search_loop(regex, current_state, buffer, length, starting_index, end, 1);
+	}
+
+	return forward_search_loop(regex, current_state, buffer, length, starting_index, end, 0);
+}
+
+
+/**
+ * A lazy DFA that has to keep throwing its states out is making a new state every few bytes, which is slower than just simulating
+ * the NFA. Once it's been flushed more than LAZY_DFA_MAX_FLUSHES times, and it's made more than one state for every
+ * LAZY_DFA_MIN_BYTES_PER_STATE bytes that it's searched, every search after this one will simulate the NFA instead
+ */
+static void check_lazy_DFA(regex_t* regex, transition_table_t* table, size_t bytes_searched, regex_mode_t mode){
+	//Nothing to worry about for a DFA that was built up front
+	if(table->builder == NULL){
+		return;
+	}
+
+	table->bytes_searched += bytes_searched;
+
+	if(table->generation > LAZY_DFA_MAX_FLUSHES && table->bytes_searched < (size_t)(table->generation) * LAZY_DFA_MAX_STATES * LAZY_DFA_MIN_BYTES_PER_STATE){
+		if(mode == REGEX_VERBOSE){
+			printf("The lazy DFA has been flushed %u times in %zu bytes, switching over to simulating the NFA\n", table->generation, table->bytes_searched);
+		}
+
+		regex->flags |= REGEX_NFA;
+	}
+}
+
+
+/**
+ * Run the forward DFA from its start state to find where the match ends
+ */
+static u_int8_t forward_search(regex_t* regex, const char* buffer, size_t length, size_t starting_index, size_t* end, regex_mode_t mode){
+	transition_table_t* table = (transition_table_t*)(regex->forward_table);
+	u_int8_t found = resume_forward_search(regex, table_start(table), buffer, length, starting_index, end, mode);
+
+	check_lazy_DFA(regex, table, (found == 1 ? *end : length) - starting_index, mode);
+
+	return found;
+}
+
+
+/**
+ * We know where the match ends, so now we need to know where it starts. The reverse DFA reads backwards from "end", and
+ * every time it accepts, a match could have started right there. We keep going until it dies, so we end up with the smallest
+ * such index. For leftmost-longest matches, that's the leftmost match, since no match can start any earlier than it
+ */
+static size_t find_match_start(regex_t* regex, const char* buffer, size_t starting_index, size_t end){
+	transition_table_t* table = (transition_table_t*)(regex->reverse_table);
+	const u_int32_t* transitions = table->transitions;
+	//The reverse DFA always starts in row 0
+	size_t row = 0;
+	u_int32_t next_state;
+	size_t start = end;
+
+	//Walk backwards until we hit the starting index or the DFA dies
+	for(size_t current_index = end; current_index > starting_index; current_index--){
+		next_state = transitions[row + (u_int8_t)buffer[current_index - 1]];
+
+		//Most states are neither dead nor accepting
+		if(next_state <= TRANSITION_ROW_MASK){
+			row = next_state;
+			continue;
+		}
+
+		//For lazy DFAs, we might have to work out where we go
+		if((next_state & TRANSITION_UNKNOWN) != 0){
+			next_state = lazy_transition(table, row, (u_int8_t)buffer[current_index - 1]);
+			transitions = table->transitions;
+
+			if(next_state <= TRANSITION_ROW_MASK){
+				row = next_state;
+				continue;
+			}
+		}
+
+		if((next_state & TRANSITION_DEAD) != 0){
+			break;
+		}
+
+		//A match could start here
+		start = current_index - 1;
+		row = next_state & TRANSITION_ROW_MASK;
+	}
+
+	return start;
+}
+
+
+/**
+ * The matcher behind every search. We scan exactly "length" bytes of the buffer in one pass and never
+ * look for a null terminator, so this can be used on slices of larger buffers. Bytes outside of the printable range
+ * can never be matched, so they end every match that they show up in
+ */
+static void match_n(regex_match_t* match, regex_t* regex, const char* buffer, size_t length, size_t starting_index, regex_mode_t mode){
+	//By default, we haven't found anything
+	match->status = MATCH_NOT_FOUND;
+	//Initialize this to the starting index
+	match->match_start_idx = starting_index;
+	//By default, these match meaning we don't have a match
+	match->match_end_idx = starting_index;
+
+	//Some regexes don't use their DFAs at all
+	if((regex->flags & REGEX_NFA) != 0){
+		simulate_NFA(match, regex, buffer, length, starting_index, 0, mode);
+		return;
+	}
+
+	//Anchored regexes have their own DFA
+	if(regex->anchored_start == 1){
+		anchored_match(match, regex, buffer, length, starting_index, 0, mode);
+		return;
+	}
+
+	//If the buffer doesn't have anything that a match needs, we don't need to run the DFA at all
+	if(regex->required_factors != NULL && contains_required_factor((required_factors_t*)(regex->required_factors), buffer + starting_index, length - starting_index) == 0){
+		if(mode == REGEX_VERBOSE){
+			printf("No required factor found, so there is no match\n");
+		}
+
+		return;
+	}
+
+	size_t end;
+
+	//If we ran off the end of the buffer without accepting, there's no match
+	if(forward_search(regex, buffer, length, starting_index, &end, mode) == 0){
+		return;
+	}
+
+	//Now that we know where it ends, we can find where it starts
+	match->match_start_idx = find_match_start(regex, buffer, starting_index, end);
+	match->match_end_idx = end;
+	match->status = MATCH_FOUND;
+
+	if(mode == REGEX_VERBOSE){
+		printf("Match found!\n");
+	}
+}
+
+
+/**
+ * The public facing match method that the user will call when attempting to pattern match
+ */
+void regex_match(regex_t* regex, regex_match_t* match_struct, char* string, u_int32_t starting_index, regex_mode_t mode){
+
+	//Error mode by default
+	match_struct->status = MATCH_ERR;
+
+	//If we are given a bad regex 
+	if(regex->program == NULL || regex->state == REGEX_ERR){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Attempt to use an invalid regex.\n");
+		}
+
+		//Pack in the values and return match.match_start = 0;
+		match_struct->match_start_idx = 0;
+		match_struct->match_end_idx = 0;
+
+		//We return this value so that the caller can know what the error was
+		match_struct->status = MATCH_INV_INPUT;
+
+		//Give the regex back
+		return;
+	}
+
+	//If we are given a bad string. We only need to look at the first byte to know if it's empty
+	if(string == NULL || *string == '\0'){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Attempt to match a NULL string or a string of length 0.\n");
+		}
+
+		//Pack in the values and return
+		match_struct->match_start_idx = 0;
+		match_struct->match_end_idx = 0;
+		match_struct->status = MATCH_INV_INPUT;
+		return;
+	}
+
+	//Anchored matches stop at the first byte that doesn't fit, so there's no need to find the end of the string
+	if(regex->anchored_start == 1 && (regex->flags & REGEX_NFA) == 0){
+		anchored_match(match_struct, regex, string, SIZE_MAX, starting_index, 0, mode);
+		return;
+	}
+
+	//Attempt to match the string with the regex
+	match_n(match_struct, regex, string, strlen(string), starting_index, mode);
+
+	//Return the match struct
+	return;
+}
+
+
+/**
+ * The public facing length delimited match method. This is the same as regex_match, except that exactly "length" bytes
+ * are scanned and no null terminator is needed
+ */
+void regex_match_n(regex_t* regex, regex_match_t* match_struct, const char* buffer, size_t length, size_t starting_index, regex_mode_t mode){
+	//Error mode by default
+	match_struct->status = MATCH_ERR;
+
+	//If we are given a bad regex 
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Attempt to use an invalid regex.\n");
+		}
+
+		//Pack in the values and return
+		match_struct->match_start_idx = 0;
+		match_struct->match_end_idx = 0;
+		match_struct->status = MATCH_INV_INPUT;
+		return;
+	}
+
+	//If we are given a bad buffer, or we're asked to start past the end of it
+	if(buffer == NULL || length == 0 || starting_index >= length){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Attempt to match a NULL buffer, a buffer of length 0 or a starting index past the end.\n");
+		}
+
+		//Pack in the values and return
+		match_struct->match_start_idx = 0;
+		match_struct->match_end_idx = 0;
+		match_struct->status = MATCH_INV_INPUT;
+		return;
+	}
+
+	//Attempt to match the buffer with the regex
+	match_n(match_struct, regex, buffer, length, starting_index, mode);
+}
+
+
+/**
+ * The public facing full match method. The whole buffer has to be a match, so we run the anchored DFA from the
+ * start and bail out at the first byte that doesn't fit
+ */
+void regex_fullmatch(regex_t* regex, regex_match_t* match_struct, const char* buffer, size_t length, regex_mode_t mode){
+	//If we are given a bad regex 
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Attempt to use an invalid regex.\n");
+		}
+
+		//Pack in the values and return
+		match_struct->match_start_idx = 0;
+		match_struct->match_end_idx = 0;
+		match_struct->status = MATCH_INV_INPUT;
+		return;
+	}
+
+	//An empty buffer is fine, but a NULL one isn't
+	if(buffer == NULL){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Attempt to match a NULL buffer.\n");
+		}
+
+		//Pack in the values and return
+		match_struct->match_start_idx = 0;
+		match_struct->match_end_idx = 0;
+		match_struct->status = MATCH_INV_INPUT;
+		return;
+	}
+
+	//Some regexes don't use their DFAs at all
+	if((regex->flags & REGEX_NFA) != 0){
+		simulate_NFA(match_struct, regex, buffer, length, 0, 1, mode);
+		return;
+	}
+
+	anchored_match(match_struct, regex, buffer, length, 0, 1, mode);
+}
+
+
+/**
+ * The public facing capture method. The match itself is found just like regex_match_n finds it, and then the capture VM reads
+ * over only the bytes of the match to find where each group is
+ */
+void regex_match_captures(regex_t* regex, regex_captures_t* captures, const char* buffer, size_t length, size_t starting_index, regex_mode_t mode){
+	regex_match_t match_struct;
+
+	//All of the checks are done in here
+	regex_match_n(regex, &match_struct, buffer, length, starting_index, mode);
+
+	captures->status = match_struct.status;
+	captures->num_groups = match_struct.status == MATCH_INV_INPUT ? 0 : regex->num_groups;
+	captures->groups[0].start = match_struct.match_start_idx;
+	captures->groups[0].end = match_struct.match_end_idx;
+
+	//Nothing has matched until we find out otherwise
+	for(u_int32_t group = 1; group <= REGEX_MAX_GROUPS; group++){
+		captures->groups[group].start = REGEX_NO_GROUP;
+		captures->groups[group].end = REGEX_NO_GROUP;
+	}
+
+	if(match_struct.status == MATCH_FOUND && regex->capture_program != NULL){
+		find_captures(regex, captures, buffer, match_struct.match_start_idx, match_struct.match_end_idx);
+
+		if(mode == REGEX_VERBOSE){
+			for(u_int32_t group = 1; group <= captures->num_groups; group++){
+				printf("Group %u: %zu to %zu\n", group, captures->groups[group].start, captures->groups[group].end);
+			}
+		}
+	}
+}
+
+
+/**
+ * The public facing boolean match method. We only need to know if there is a match, not where it is, so we stop at the very
+ * first accepting state that we see. Nothing else is kept track of, and there is never a backwards pass to find where the
+ * match starts
+ */
+match_status_t regex_is_match(regex_t* regex, const char* buffer, size_t length){
+	//If we are given a bad regex or a bad buffer, there's nothing to do
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR || buffer == NULL || length == 0){
+		return MATCH_INV_INPUT;
+	}
+
+	//Some regexes don't use their DFAs at all
+	if((regex->flags & REGEX_NFA) != 0){
+		regex_match_t match_struct;
+		simulate_NFA(&match_struct, regex, buffer, length, 0, 0, REGEX_SILENT);
+		return match_struct.status;
+	}
+
+	//Anchored regexes have their own DFA
+	transition_table_t* table = (transition_table_t*)(regex->anchored_start == 1 ? regex->anchored_table : regex->forward_table);
+	u_int32_t current_state = table_start(table);
+
+	//If the empty string matches, everything does
+	if((current_state & TRANSITION_ACCEPTING) != 0){
+		return MATCH_FOUND;
+	}
+
+	//If the buffer doesn't have anything that a match needs, we don't need to run the DFA at all
+	if(regex->required_factors != NULL && contains_required_factor((required_factors_t*)(regex->required_factors), buffer, length) == 0){
+		return MATCH_NOT_FOUND;
+	}
+
+	for(size_t current_index = 0; current_index < length; current_index++){
+		//If we're sitting in the start state, nothing can begin until we see the literal prefix or a byte in the start set
+		if((current_state & TRANSITION_START) != 0){
+			const char* candidate = find_match_candidate(regex, buffer + current_index, length - current_index);
+
+			if(candidate == NULL){
+				return MATCH_NOT_FOUND;
+			}
+
+			current_index = candidate - buffer;
+		}
+
+		current_state = table_transition(table, current_state & TRANSITION_ROW_MASK, (u_int8_t)buffer[current_index]);
+
+		//Nearly every state has no flags at all
+		if(current_state <= TRANSITION_ROW_MASK){
+			continue;
+		}
+
+		//Any match at all is good enough
+		if((current_state & TRANSITION_ACCEPTING) != 0){
+			return MATCH_FOUND;
+		}
+
+		//Only the anchored DFA can die before it accepts
+		if((current_state & TRANSITION_DEAD) != 0){
+			return MATCH_NOT_FOUND;
+		}
+	}
+
+	return MATCH_NOT_FOUND;
+}
+
+
+/**
+ * One lane of the batch matcher. Each lane holds an input that is in the middle of being matched
+ */
+typedef struct {
+	//The input that this lane is working on
+	const char* buffer;
+	size_t length;
+	//Where we are in that input
+	size_t current_index;
+	//The packed state that this lane is in
+	u_int32_t current_state;
+	//Where the result goes
+	regex_match_t* match;
+	//Have we found a match yet? If so, match_end_idx is where it ends
+	u_int8_t found;
+} batch_lane_t;
+
+
+/**
+ * A lane is done with its input, so we'll fill in its result. If we found a match, all that's left is to find where it starts
+ */
+static void finish_batch_lane(batch_lane_t* lane, regex_t* regex){
+	if(lane->found == 1){
+		lane->match->match_start_idx = find_match_start(regex, lane->buffer, 0, lane->match->match_end_idx);
+		lane->match->status = MATCH_FOUND;
+	} else {
+		lane->match->match_start_idx = 0;
+		lane->match->match_end_idx = 0;
+		lane->match->status = MATCH_NOT_FOUND;
+	}
+}
+
+
+/**
+ * Load the next input into a lane. Returns 1 if the lane has something to work on, 0 if
+ * we've run out of inputs. Inputs that can be resolved right away never take up a lane
+ */
+static u_int8_t load_batch_lane(batch_lane_t* lane, regex_t* regex, const regex_span_t* inputs, size_t num_inputs, size_t* next_input, regex_match_t* results){
+	u_int32_t start_state = table_start((transition_table_t*)(regex->forward_table));
+	required_factors_t* factors = (required_factors_t*)(regex->required_factors);
+
+	while(*next_input < num_inputs){
+		const regex_span_t* input = &(inputs[*next_input]);
+		regex_match_t* match = &(results[*next_input]);
+		(*next_input)++;
+
+		//Everything starts out at 0
+		match->match_start_idx = 0;
+		match->match_end_idx = 0;
+
+		//Just like regex_match_n, empty or NULL inputs are invalid
+		if(input->buffer == NULL || input->length == 0){
+			match->status = MATCH_INV_INPUT;
+			continue;
+		}
+
+		//Otherwise, there's no match unless there's something here that a match needs
+		match->status = MATCH_NOT_FOUND;
+		if(factors != NULL && contains_required_factor(factors, input->buffer, input->length) == 0){
+			continue;
+		}
+
+		//This lane is now working on this input
+		lane->buffer = input->buffer;
+		lane->length = input->length;
+		lane->current_index = 0;
+		lane->current_state = start_state;
+		lane->match = match;
+		lane->found = (start_state & TRANSITION_ACCEPTING) != 0;
+
+		//An earliest match of the empty string is already done
+		if(lane->found == 1 && (regex->flags & REGEX_EARLIEST) != 0){
+			finish_batch_lane(lane, regex);
+			continue;
+		}
+
+		return 1;
+	}
+
+	//Nothing left to load
+	return 0;
+}
+
+
+/**
+ * Match a whole batch of inputs against the same regex. We keep BATCH_LANES inputs in flight at once and advance
+ * each of them by one byte per round. The lanes don't depend on one another, so the CPU is free to overlap
+ * their transition lookups instead of waiting on one lookup at a time. As soon as a lane finishes, it's refilled
+ * with the next input
+ */
+void regex_match_batch(regex_t* regex, const regex_span_t* inputs, size_t num_inputs, regex_match_t* results){
+	//If we are given a bad regex, everything is invalid
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR || inputs == NULL){
+		for(size_t i = 0; results != NULL && i < num_inputs; i++){
+			results[i].match_start_idx = 0;
+			results[i].match_end_idx = 0;
+			results[i].status = MATCH_INV_INPUT;
+		}
+
+		return;
+	}
+
+	//Anchored matches stop almost right away, so there's nothing to gain from interleaving them. A lazy DFA can be flushed while
+	//a lane is in the middle of it, so those are matched one at a time too, along with regexes that only simulate their NFA
+	if(regex->anchored_start == 1 || (regex->flags & REGEX_NFA) != 0 || ((transition_table_t*)(regex->forward_table))->builder != NULL){
+		for(size_t i = 0; i < num_inputs; i++){
+			regex_match_n(regex, &(results[i]), inputs[i].buffer, inputs[i].length, 0, REGEX_SILENT);
+		}
+
+		return;
+	}
+
+	u_int8_t earliest = (regex->flags & REGEX_EARLIEST) != 0;
+	const u_int32_t* transitions = ((transition_table_t*)(regex->forward_table))->transitions;
+	u_int32_t next_state;
+	batch_lane_t lanes[BATCH_LANES];
+	batch_lane_t* lane;
+	u_int8_t num_active = 0;
+	size_t next_input = 0;
+
+	//Fill up every lane that we can
+	while(num_active < BATCH_LANES && load_batch_lane(&(lanes[num_active]), regex, inputs, num_inputs, &next_input, results) == 1){
+		num_active++;
+	}
+
+	//Keep going so long as any lane has work to do
+	while(num_active > 0){
+		//Advance every lane by one byte
+		u_int8_t i = 0;
+		while(i < num_active){
+			lane = &(lanes[i]);
+
+			//This is the exact same step that forward_search takes
+			next_state = transitions[(lane->current_state & TRANSITION_ROW_MASK) + (u_int8_t)lane->buffer[lane->current_index]];
+			lane->current_state = next_state;
+			lane->current_index++;
+
+			//Nearly every state has no flags at all, so the lane just moves on unless it's out of input
+			if(next_state <= TRANSITION_ROW_MASK){
+				if(lane->current_index < lane->length){
+					i++;
+					continue;
+				}
+
+				goto lane_finished;
+			}
+
+			//If the DFA died, nothing can beat the match that this lane already has
+			if((next_state & TRANSITION_DEAD) != 0){
+				goto lane_finished;
+			}
+
+			//Remember where this match ends
+			if((next_state & TRANSITION_ACCEPTING) != 0){
+				lane->found = 1;
+				lane->match->match_end_idx = lane->current_index;
+
+				//Earliest matches are done right away
+				if(earliest == 1){
+					goto lane_finished;
+				}
+			}
+
+			//If the lane still has input left, we'll move on to the next one
+			if(lane->current_index < lane->length){
+				i++;
+				continue;
+			}
+
+		lane_finished:
+			finish_batch_lane(lane, regex);
+
+			//Refill the lane if we can
+			if(load_batch_lane(lane, regex, inputs, num_inputs, &next_input, results) == 1){
+				i++;
+			//If we can't, the last active lane takes this one's place and gets its turn next
+			} else {
+				num_active--;
+				lanes[i] = lanes[num_active];
+			}
+		}
+	}
+}
+
+
+/**
+ * One lane of the lockstep matcher. Each lane runs a different regex, and every lane reads the same byte at the same time
+ */
+typedef struct {
+	//Which regex this lane is running
+	u_int32_t regex_index;
+	//The flattened table that it's walking, and the packed state that it's in
+	const u_int32_t* transitions;
+	u_int32_t state;
+} lockstep_lane_t;
+
+
+/**
+ * Load the next regex into a lane. Returns 1 if the lane has something to work on, 0 if we've run out of regexes. Regexes
+ * that can be resolved without reading the buffer never take up a lane, and neither do the ones that have to be run on their
+ * own: a lazy table can be flushed in the middle of the loop, some regexes only simulate their NFA, and some are better off
+ * skipping ahead with their literal prefix
+ */
+static u_int8_t load_lockstep_lane(lockstep_lane_t* lane, regex_t** regexes, u_int32_t num_regexes, u_int32_t* next_regex, const char* buffer, size_t length, u_int8_t* matched, u_int32_t* num_matched){
+	while(*next_regex < num_regexes){
+		u_int32_t regex_index = *next_regex;
+		regex_t* regex = regexes[regex_index];
+		(*next_regex)++;
+
+		//Nothing matches unless we find it
+		matched[regex_index] = 0;
+
+		//Bad regexes never match
+		if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR){
+			continue;
+		}
+
+		transition_table_t* table = (transition_table_t*)(regex->anchored_start == 1 ? regex->anchored_table : regex->forward_table);
+
+		//These go on their own. Jumping between copies of a literal prefix with memmem is far faster than reading every byte
+		if((regex->flags & REGEX_NFA) != 0 || table->builder != NULL || (regex->anchored_start == 0 && regex->literal_prefix != NULL)){
+			matched[regex_index] = regex_is_match(regex, buffer, length) == MATCH_FOUND;
+			*num_matched += matched[regex_index];
+			continue;
+		}
+
+		u_int32_t start_state = table_start(table);
+
+		//If the empty string matches, everything does
+		if((start_state & TRANSITION_ACCEPTING) != 0){
+			matched[regex_index] = 1;
+			(*num_matched)++;
+			continue;
+		}
+
+		//If the buffer doesn't have anything that a match needs, we don't need to run the DFA at all
+		if(regex->required_factors != NULL && contains_required_factor((required_factors_t*)(regex->required_factors), buffer, length) == 0){
+			continue;
+		}
+
+		lane->regex_index = regex_index;
+		lane->transitions = table->transitions;
+		lane->state = start_state;
+
+		return 1;
+	}
+
+	//Nothing left to load
+	return 0;
+}
+
+
+/**
+ * Check the same buffer against many regexes, reading it once for every BATCH_LANES of them. Every lane steps over the same
+ * byte before any of them moves on to the next one. The lanes' lookups don't depend on one another, so the CPU is free to
+ * overlap them, and the byte only has to be loaded once. A lane drops out as soon as its regex matches, or as soon as an anchored
+ * regex can't match anymore. Once a single lane is left sitting in its start state, there's nothing to overlap it with, so it
+ * finishes on its own with regex_is_match, which can skip ahead
+ */
+u_int32_t regex_match_lockstep(regex_t** regexes, u_int32_t num_regexes, const char* buffer, size_t length, u_int8_t* matched){
+	lockstep_lane_t lanes[BATCH_LANES];
+	lockstep_lane_t* lane;
+	u_int32_t num_matched = 0;
+	u_int32_t next_regex = 0;
+	u_int8_t num_active;
+	u_int8_t i;
+	u_int8_t ch;
+
+	//If we are given nothing to work with, nothing matches
+	if(regexes == NULL || matched == NULL){
+		return 0;
+	}
+
+	//Just like regex_is_match, empty or NULL buffers never match
+	if(buffer == NULL || length == 0){
+		memset(matched, 0, num_regexes);
+		return 0;
+	}
+
+	//Every group of lanes gets its own pass over the buffer
+	while(next_regex < num_regexes){
+		num_active = 0;
+
+		//Fill up every lane that we can
+		while(num_active < BATCH_LANES && load_lockstep_lane(&(lanes[num_active]), regexes, num_regexes, &next_regex, buffer, length, matched, &num_matched) == 1){
+			num_active++;
+		}
+
+		for(size_t current_index = 0; current_index < length && num_active > 0; current_index++){
+			ch = (u_int8_t)buffer[current_index];
+
+			//Advance every lane over this byte
+			i = 0;
+			while(i < num_active){
+				lane = &(lanes[i]);
+				lane->state = lane->transitions[(lane->state & TRANSITION_ROW_MASK) + ch];
+
+				//Nearly every state has no flags at all
+				if(lane->state <= TRANSITION_ROW_MASK){
+					i++;
+					continue;
+				}
+
+				//Any match at all is good enough
+				if((lane->state & TRANSITION_ACCEPTING) != 0){
+					matched[lane->regex_index] = 1;
+					num_matched++;
+
+				//Only anchored DFAs die, and they're done once they do. Otherwise the lane keeps going
+				} else if((lane->state & TRANSITION_DEAD) == 0){
+					i++;
+					continue;
+				}
+
+				//The last active lane takes this one's place and gets its turn next
+				num_active--;
+				lanes[i] = lanes[num_active];
+			}
+
+			//A lone lane in its start state can skip ahead on its own. Only unanchored DFAs ever get back to the start state
+			if(num_active == 1 && (lanes[0].state & TRANSITION_START) != 0){
+				matched[lanes[0].regex_index] = regex_is_match(regexes[lanes[0].regex_index], buffer + current_index + 1, length - current_index - 1) == MATCH_FOUND;
+				num_matched += matched[lanes[0].regex_index];
+				num_active = 0;
+			}
+		}
+	}
+
+	return num_matched;
+}
+
+
+/**
+ * Everything that one thread needs to simulate its chunk of the buffer in regex_match_parallel. We don't know what state
+ * the DFA will be in when it gets to the start of the chunk, so the chunk is run from every one of the "origins" at once.
+ * For every origin, we record where it ends up and whether it accepted or died along the way
+ */
+typedef struct {
+	//The buffer and the part of it that this chunk covers
+	const char* buffer;
+	size_t chunk_start;
+	size_t chunk_end;
+	//The forward DFA's packed transitions
+	const u_int32_t* transitions;
+	//The row of every state that we could be in at the start of the chunk
+	u_int32_t* origins;
+	u_int32_t num_origins;
+	//How many states the DFA has in total
+	u_int32_t num_dfa_states;
+	//The row that each origin ends up in. This means nothing for an origin that accepted or died
+	u_int32_t* finals;
+	//Set for each origin that accepted or died somewhere in this chunk
+	u_int8_t* hits;
+	//For each origin that was hit, the row of the state that it was in right before and the index of the byte that did it
+	u_int32_t* hit_states;
+	size_t* hit_indices;
+	//Set by the caller once it knows that nobody needs this chunk anymore
+	u_int8_t* cancelled;
+} parallel_chunk_t;
+
+
+/**
+ * Run one chunk from every origin at the same time. Most DFAs forget where they started after only a few bytes, so
+ * origins that land in the same state are merged together and only stepped once from then on. Origins that accept or
+ * die are dropped as well, because the caller will rescan that chunk for real if it turns out to need them. This means
+ * that after a short warm up, we're usually only stepping one state per byte
+ */
+static void* simulate_chunk(void* arg){
+	parallel_chunk_t* chunk = (parallel_chunk_t*)arg;
+	const u_int32_t* transitions = chunk->transitions;
+	u_int32_t num_lanes = chunk->num_origins;
+	//Every origin starts out as its own lane. Each lane holds the row of the state that it's in
+	u_int32_t* lane_states = malloc(num_lanes * sizeof(u_int32_t));
+	u_int8_t* lane_hits = calloc(num_lanes, sizeof(u_int8_t));
+	u_int32_t* lane_hit_states = malloc(num_lanes * sizeof(u_int32_t));
+	size_t* lane_hit_indices = malloc(num_lanes * sizeof(size_t));
+	//When a lane is merged into another one, it points to the one that it was merged into
+	u_int32_t* lane_parents = malloc(num_lanes * sizeof(u_int32_t));
+	//The lanes that are still being stepped
+	u_int32_t* active = malloc(num_lanes * sizeof(u_int32_t));
+	//Which lane landed on each DFA state in the current step
+	u_int32_t* owners = malloc(chunk->num_dfa_states * sizeof(u_int32_t));
+	size_t* owner_steps = calloc(chunk->num_dfa_states, sizeof(size_t));
+	u_int32_t num_active = num_lanes;
+	size_t current_index = chunk->chunk_start;
+	u_int32_t next_state;
+	u_int32_t next_id;
+	u_int32_t lane;
+	u_int32_t kept;
+	u_int8_t ch;
+
+	for(u_int32_t i = 0; i < num_lanes; i++){
+		lane_states[i] = chunk->origins[i];
+		lane_parents[i] = i;
+		active[i] = i;
+	}
+
+	//Step every lane until they've all been merged into one
+	for(; current_index < chunk->chunk_end && num_active > 1; current_index++){
+		ch = (u_int8_t)chunk->buffer[current_index];
+		//The step number is one past the index so that it's never 0, which is what the owners start out as
+		size_t step = current_index + 1;
+		kept = 0;
+
+		for(u_int32_t i = 0; i < num_active; i++){
+			lane = active[i];
+			next_state = transitions[lane_states[lane] + ch];
+
+			//If this lane died or accepted, the caller will have to scan from here for real, so we're done with it
+			if((next_state & (TRANSITION_DEAD | TRANSITION_ACCEPTING)) != 0){
+				lane_hits[lane] = 1;
+				lane_hit_states[lane] = lane_states[lane];
+				lane_hit_indices[lane] = current_index;
+				continue;
+			}
+
+			next_state &= TRANSITION_ROW_MASK;
+			next_id = next_state >> 8;
+
+			//If another lane is already here, they'll go the same way from now on
+			if(owner_steps[next_id] == step){
+				lane_parents[lane] = owners[next_id];
+				continue;
+			}
+
+			owner_steps[next_id] = step;
+			owners[next_id] = lane;
+			lane_states[lane] = next_state;
+			active[kept] = lane;
+			kept++;
+		}
+
+		num_active = kept;
+	}
+
+	//Once there's only one lane left, this is just a normal walk through the table
+	if(num_active == 1){
+		lane = active[0];
+		size_t row = lane_states[lane];
+
+		for(; current_index < chunk->chunk_end; current_index++){
+			//Every so often, check if we should give up
+			if((current_index & 0xFFFF) == 0 && __atomic_load_n(chunk->cancelled, __ATOMIC_RELAXED) == 1){
+				break;
+			}
+
+			next_state = transitions[row + (u_int8_t)chunk->buffer[current_index]];
+
+			//Getting back to the start state doesn't matter in here, only accepting or dying does. Checking for just those two
+			//keeps patterns that keep falling back to the start state on the fast path
+			if((next_state & (TRANSITION_DEAD | TRANSITION_ACCEPTING)) != 0){
+				lane_hits[lane] = 1;
+				lane_hit_states[lane] = row;
+				lane_hit_indices[lane] = current_index;
+				break;
+			}
+
+			row = next_state & TRANSITION_ROW_MASK;
+		}
+
+		lane_states[lane] = row;
+	}
+
+	//Now follow each origin to the lane that it ended up in. Lanes stop being stepped once they're hit, so only the
+	//last lane along the way can have been hit
+	for(u_int32_t i = 0; i < num_lanes; i++){
+		lane = i;
+
+		while(lane_parents[lane] != lane){
+			lane = lane_parents[lane];
+		}
+
+		chunk->finals[i] = lane_states[lane];
+		chunk->hits[i] = lane_hits[lane];
+		chunk->hit_states[i] = lane_hit_states[lane];
+		chunk->hit_indices[i] = lane_hit_indices[lane];
+	}
+
+	free(lane_states);
+	free(lane_hits);
+	free(lane_hit_states);
+	free(lane_hit_indices);
+	free(lane_parents);
+	free(active);
+	free(owners);
+	free(owner_steps);
+
+	return NULL;
+}
+
+
+/**
+ * Find the first match in one huge buffer using several threads. The buffer is cut into one chunk per thread, and every chunk
+ * but the first is run speculatively from every state in the forward DFA, since we can't know which one it'll really start
+ * in until the chunk before it is done. Once every chunk is done, we stitch them together in order: the state that the first
+ * chunk ends in tells us which run of the second chunk was the real one, and so on. The first chunk where the real run accepted
+ * or died is scanned one more time like normal, which gives us the exact same match that regex_match_n would have found
+ */
+void regex_match_parallel(regex_t* regex, regex_match_t* match_struct, const char* buffer, size_t length, u_int32_t num_threads, regex_mode_t mode){
+	//Error mode by default
+	match_struct->status = MATCH_ERR;
+
+	//If we are given a bad regex 
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Attempt to use an invalid regex.\n");
+		}
+
+		//Pack in the values and return
+		match_struct->match_start_idx = 0;
+		match_struct->match_end_idx = 0;
+		match_struct->status = MATCH_INV_INPUT;
+		return;
+	}
+
+	//If we are given a bad buffer
+	if(buffer == NULL || length == 0){
+		//Verbose mode
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX ERROR: Attempt to match a NULL buffer or a buffer of length 0.\n");
+		}
+
+		//Pack in the values and return
+		match_struct->match_start_idx = 0;
+		match_struct->match_end_idx = 0;
+		match_struct->status = MATCH_INV_INPUT;
+		return;
+	}
+
+	transition_table_t* table = (transition_table_t*)(regex->forward_table);
+
+	if(num_threads > PARALLEL_MAX_THREADS){
+		num_threads = PARALLEL_MAX_THREADS;
+	}
+
+	//Don't use more threads than we have chunks to give them
+	if(num_threads > length / PARALLEL_MIN_CHUNK){
+		num_threads = length / PARALLEL_MIN_CHUNK;
+	}
+
+	//Anchored matches are over almost right away, and so are regexes that match the empty string. Neither of them are worth
+	//splitting up, and neither is a buffer that's too small to go around. Lazy DFAs make states as they go, so they can't be
+	//shared between threads, and we don't know all of their states up front anyway. Regexes that only simulate their NFA don't
+	//have a DFA to stitch the chunks together with
+	if(num_threads <= 1 || regex->anchored_start == 1 || (regex->flags & REGEX_NFA) != 0 || table->builder != NULL || (table_start(table) & TRANSITION_ACCEPTING) != 0){
+		match_n(match_struct, regex, buffer, length, 0, mode);
+		return;
+	}
+
+	match_struct->status = MATCH_NOT_FOUND;
+	match_struct->match_start_idx = 0;
+	match_struct->match_end_idx = 0;
+
+	//If the buffer doesn't have anything that a match needs, we don't need to run the DFA at all
+	if(regex->required_factors != NULL && contains_required_factor((required_factors_t*)(regex->required_factors), buffer, length) == 0){
 		if(mode == REGEX_VERBOSE){
-			printf("REGEX ERROR: DFA creation failed.\n");
-			regex->state = REGEX_ERR;
-			free(postfix);
-			return regex;
+			printf("No required factor found, so there is no match\n");
+		}
+
+		return;
+	}
+
+	//Every chunk after the first could start in any state, so we'll need all of them. The start state is always in row 0
+	u_int32_t num_dfa_states = table->num_states;
+	u_int32_t start_row = 0;
+
+	u_int32_t* dfa_rows = malloc(num_dfa_states * sizeof(u_int32_t));
+	for(u_int32_t i = 0; i < num_dfa_states; i++){
+		dfa_rows[i] = i << 8;
+	}
+
+	parallel_chunk_t chunks[PARALLEL_MAX_THREADS];
+	pthread_t threads[PARALLEL_MAX_THREADS];
+	u_int8_t started[PARALLEL_MAX_THREADS];
+	size_t chunk_length = length / num_threads;
+	u_int8_t cancelled = 0;
+
+	for(u_int32_t i = 0; i < num_threads; i++){
+		chunks[i].buffer = buffer;
+		chunks[i].chunk_start = i * chunk_length;
+		//The last chunk picks up whatever is left over
+		chunks[i].chunk_end = i == num_threads - 1 ? length : (i + 1) * chunk_length;
+		chunks[i].transitions = table->transitions;
+		chunks[i].num_dfa_states = num_dfa_states;
+		chunks[i].cancelled = &cancelled;
+
+		//The first chunk is the only one that we know the start of
+		if(i == 0){
+			chunks[i].origins = &start_row;
+			chunks[i].num_origins = 1;
+		} else {
+			chunks[i].origins = dfa_rows;
+			chunks[i].num_origins = num_dfa_states;
+		}
+
+		chunks[i].finals = malloc(chunks[i].num_origins * sizeof(u_int32_t));
+		chunks[i].hits = malloc(chunks[i].num_origins * sizeof(u_int8_t));
+		chunks[i].hit_states = malloc(chunks[i].num_origins * sizeof(u_int32_t));
+		chunks[i].hit_indices = malloc(chunks[i].num_origins * sizeof(size_t));
+	}
+
+	//Everyone but the first chunk gets their own thread
+	for(u_int32_t i = 1; i < num_threads; i++){
+		started[i] = pthread_create(&(threads[i]), NULL, simulate_chunk, &(chunks[i])) == 0;
+
+		//If we couldn't get a thread, we'll just have to do it ourselves
+		if(started[i] == 0){
+			simulate_chunk(&(chunks[i]));
+		}
+	}
+
+	//We'll take care of the first one ourselves. If the match is in there, nobody else's work matters
+	simulate_chunk(&(chunks[0]));
+
+	if(chunks[0].hits[0] == 1){
+		__atomic_store_n(&cancelled, 1, __ATOMIC_RELAXED);
+	}
+
+	for(u_int32_t i = 1; i < num_threads; i++){
+		if(started[i] == 1){
+			pthread_join(threads[i], NULL);
+		}
+	}
+
+	//Now stitch the chunks together, following the real run from one chunk into the next
+	u_int32_t current_row = start_row;
+	size_t end;
+
+	for(u_int32_t i = 0; i < num_threads; i++){
+		u_int32_t origin = i == 0 ? 0 : current_row >> 8;
+
+		//This is where the real run accepts or dies, so this is where the match is. We know exactly what state we were in
+		//right before it happened, so a normal scan from there finds the same match that a scan from the very start would
+		if(chunks[i].hits[origin] == 1){
+			if(mode == REGEX_VERBOSE){
+				printf("Match is in chunk %u, resuming at index: %zu\n", i, chunks[i].hit_indices[origin]);
+			}
+
+			if(resume_forward_search(regex, pack_DFA_state(table, table->states[chunks[i].hit_states[origin] >> 8]), buffer, length, chunks[i].hit_indices[origin], &end, mode) == 1){
+				match_struct->match_start_idx = find_match_start(regex, buffer, 0, end);
+				match_struct->match_end_idx = end;
+				match_struct->status = MATCH_FOUND;
+
+				if(mode == REGEX_VERBOSE){
+					printf("Match found!\n");
+				}
+			}
+
+			break;
+		}
+
+		current_row = chunks[i].finals[origin];
+	}
+
+	for(u_int32_t i = 0; i < num_threads; i++){
+		free(chunks[i].finals);
+		free(chunks[i].hits);
+		free(chunks[i].hit_states);
+		free(chunks[i].hit_indices);
+	}
+
+	free(dfa_rows);
+}
+
+
+/**
+ * Initialize an iterator. All of the validation is done once here, so that each call to
+ * regex_iter_next is just a continuation of the same forward scan
+ */
+void regex_iter_init(regex_iter_t* iter, regex_t* regex, const char* buffer, size_t length){
+	iter->regex = regex;
+	iter->buffer = buffer;
+	iter->length = length;
+	iter->position = 0;
+
+	//If we were given anything bad, we'll put the iterator at the end so that it never finds anything
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR || buffer == NULL){
+		iter->length = 0;
+	}
+}
+
+
+/**
+ * Find the next match for the iterator. The search picks up right where the last match
+ * ended, so no byte is ever scanned twice
+ */
+match_status_t regex_iter_next(regex_iter_t* iter, regex_match_t* match_struct){
+	//If we're already at the end, there's nothing more to find
+	if(iter->position >= iter->length){
+		match_struct->match_start_idx = iter->length;
+		match_struct->match_end_idx = iter->length;
+		match_struct->status = MATCH_NOT_FOUND;
+		return MATCH_NOT_FOUND;
+	}
+
+	//Pick up where we left off
+	match_n(match_struct, iter->regex, iter->buffer, iter->length, iter->position, REGEX_SILENT);
+
+	//If we found nothing, then nothing is left in the buffer
+	if(match_struct->status != MATCH_FOUND){
+		iter->position = iter->length;
+		return match_struct->status;
+	}
+
+	//The next search starts where this one ended. If the match was empty, we need to step over
+	//one byte so that we're guaranteed to make progress
+	if(match_struct->match_end_idx == match_struct->match_start_idx){
+		iter->position = match_struct->match_end_idx + 1;
+	} else {
+		iter->position = match_struct->match_end_idx;
+	}
+
+	return MATCH_FOUND;
+}
+
+
+/**
+ * Find every non-overlapping match in the buffer in a single forward pass
+ */
+size_t regex_find_all(regex_t* regex, const char* buffer, size_t length, regex_match_t* matches, size_t max_matches, regex_match_callback_t callback, void* user_data){
+	//The number of matches that we've found
+	size_t num_found = 0;
+	regex_iter_t iter;
+	regex_match_t match_struct;
+
+	//If we have nowhere to put anything, there's no point in searching
+	if(callback == NULL && (matches == NULL || max_matches == 0)){
+		return 0;
+	}
+
+	//Validation is done once in here
+	regex_iter_init(&iter, regex, buffer, length);
+
+	//Go through every match
+	while(regex_iter_next(&iter, &match_struct) == MATCH_FOUND){
+		//Store it if we have room
+		if(matches != NULL && num_found < max_matches){
+			matches[num_found] = match_struct;
+		}
+
+		num_found++;
+
+		//Let the callback see it. If it wants us to stop, we stop
+		if(callback != NULL){
+			if(callback(&match_struct, user_data) != 0){
+				break;
+			}
+		//If there's no callback and the array is full, we're done
+		} else if(num_found == max_matches){
+			break;
+		}
+	}
+
+	return num_found;
+}
+
+
+/**
+ * Count every non-overlapping match in the buffer. This finds the exact same matches that regex_find_all does, but only where
+ * each one ends matters for finding the next one, so we never need to find where any of them start
+ */
+size_t regex_count(regex_t* regex, const char* buffer, size_t length){
+	size_t num_found = 0;
+	size_t position = 0;
+	size_t end;
+	u_int8_t found;
+	regex_match_t match_struct;
+
+	//If we are given a bad regex or a bad buffer, there's nothing to count
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR || buffer == NULL || length == 0){
+		return 0;
+	}
+
+	//An anchored regex can only ever match once, right at the start
+	if(regex->anchored_start == 1){
+		match_n(&match_struct, regex, buffer, length, 0, REGEX_SILENT);
+		return match_struct.status == MATCH_FOUND;
+	}
+
+	//If the buffer doesn't have anything that a match needs, there's nothing to count
+	if(regex->required_factors != NULL && contains_required_factor((required_factors_t*)(regex->required_factors), buffer, length) == 0){
+		return 0;
+	}
+
+	while(position < length){
+		//Without a DFA, we have to find the whole match to know where it ends. A lazy DFA can give up on itself partway
+		//through, so we check this every time
+		if((regex->flags & REGEX_NFA) != 0){
+			simulate_NFA(&match_struct, regex, buffer, length, position, 0, REGEX_SILENT);
+			found = match_struct.status == MATCH_FOUND;
+			end = match_struct.match_end_idx;
+		} else {
+			found = forward_search(regex, buffer, length, position, &end, REGEX_SILENT);
+		}
+
+		if(found == 0){
+			break;
+		}
+
+		num_found++;
+
+		//A match can only be empty if it ends right where we started looking. Just like regex_iter_next, we need to
+		//step over one byte after an empty match so that we're guaranteed to make progress
+		if(end == position){
+			position = end + 1;
+		} else {
+			position = end;
+		}
+	}
+
+	return num_found;
+}
+
+
+/**
+ * Where the line that "index" is in ends. This is the index of its newline, or the end of the buffer for the last line
+ */
+static size_t line_end(const char* buffer, size_t length, size_t index){
+	const char* newline = memchr(buffer + index, '\n', length - index);
+
+	return newline == NULL ? length : (size_t)(newline - buffer);
+}
+
+
+/**
+ * Find the first line at or after "position" that has a match in it, and fill in "index" with some index inside of that line. No
+ * pattern can ever match a newline, so a match never crosses from one line into the next, and the unanchored DFA is back in its
+ * start state after every newline without us doing anything. The anchored DFA dies instead, and we start it over on the next line
+ */
+static u_int8_t find_matching_line(regex_t* regex, const char* buffer, size_t length, size_t position, size_t* index){
+	regex_match_t match_struct;
+
+	//Regexes that simulate their NFA find the leftmost match, and whatever line it starts in is the one that we want
+	if((regex->flags & REGEX_NFA) != 0){
+		//Unanchored regexes can search everything that's left at once
+		if(regex->anchored_start == 0){
+			simulate_NFA(&match_struct, regex, buffer, length, position, 0, REGEX_SILENT);
+			*index = match_struct.match_start_idx;
+			return match_struct.status == MATCH_FOUND;
+		}
+
+		//Anchored ones have to start over at every line
+		while(position < length){
+			simulate_NFA(&match_struct, regex, buffer + position, length - position, 0, 0, REGEX_SILENT);
+
+			if(match_struct.status == MATCH_FOUND){
+				*index = position;
+				return 1;
+			}
+
+			position = line_end(buffer, length, position) + 1;
+		}
+
+		return 0;
+	}
+
+	transition_table_t* table = (transition_table_t*)(regex->anchored_start == 1 ? regex->anchored_table : regex->forward_table);
+	u_int32_t current_state = table_start(table);
+
+	//If the empty string matches, every line does
+	if((current_state & TRANSITION_ACCEPTING) != 0){
+		*index = position;
+		return 1;
+	}
+
+	for(size_t current_index = position; current_index < length; current_index++){
+		//If we're sitting in the start state, nothing can begin until we see the literal prefix or a byte in the start set
+		if((current_state & TRANSITION_START) != 0){
+			const char* candidate = find_match_candidate(regex, buffer + current_index, length - current_index);
+
+			if(candidate == NULL){
+				return 0;
+			}
+
+			current_index = candidate - buffer;
+		}
+
+		current_state = table_transition(table, current_state & TRANSITION_ROW_MASK, (u_int8_t)buffer[current_index]);
+
+		//Nearly every state has no flags at all
+		if(current_state <= TRANSITION_ROW_MASK){
+			continue;
+		}
+
+		//Any match at all means that this line matches
+		if((current_state & TRANSITION_ACCEPTING) != 0){
+			*index = current_index;
+			return 1;
+		}
+
+		//Only the anchored DFA can die. This line can't match anymore, so the loop steps over its newline and we start over
+		if((current_state & TRANSITION_DEAD) != 0){
+			current_index = line_end(buffer, length, current_index);
+			current_state = table_start(table);
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * Report every line that has a match in it. The whole buffer is scanned once, and the moment that a line is known to match, we
+ * jump straight to its newline with memchr instead of looking at the rest of it. Line numbers are only worked out for the lines
+ * that match, by counting the newlines that we skipped over
+ */
+size_t regex_match_lines(regex_t* regex, const char* buffer, size_t length, regex_line_callback_t callback, void* user_data){
+	size_t num_found = 0;
+	size_t position = 0;
+	size_t index;
+	const char* newline;
+	regex_line_t line;
+
+	//If we are given a bad regex or a bad buffer, there are no lines to match
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR || buffer == NULL || length == 0){
+		return 0;
+	}
+
+	//If the buffer doesn't have anything that a match needs, no line can match
+	if(regex->required_factors != NULL && contains_required_factor((required_factors_t*)(regex->required_factors), buffer, length) == 0){
+		return 0;
+	}
+
+	line.line_number = 1;
+	line.line_start = 0;
+
+	//A newline at the very end of the buffer ends the last line, it doesn't start a new one
+	while(position < length && find_matching_line(regex, buffer, length, position, &index) == 1){
+		//Catch the line number up to the line that the match is in
+		while((newline = memchr(buffer + line.line_start, '\n', index - line.line_start)) != NULL){
+			line.line_number++;
+			line.line_start = newline - buffer + 1;
+		}
+
+		line.line_end = line_end(buffer, length, index);
+		num_found++;
+
+		//Let the callback see it. If it wants us to stop, we stop
+		if(callback != NULL && callback(&line, user_data) != 0){
+			break;
+		}
+
+		//The next search starts on the next line
+		position = line.line_end + 1;
+		line.line_number++;
+		line.line_start = position;
+	}
+
+	return num_found;
+}
+
+
+/**
+ * Get the byte at the absolute offset "index". Anything before "chunk_offset" came in an earlier chunk and lives
+ * in the stream's history, and everything else is in the chunk that we're being fed right now
+ */
+static u_int8_t stream_byte(regex_stream_t* stream, const char* chunk, size_t chunk_offset, size_t index){
+	if(index < chunk_offset){
+		return (u_int8_t)stream->history[stream->history_length - (chunk_offset - index)];
+	}
+
+	return (u_int8_t)chunk[index - chunk_offset];
+}
+
+
+/**
+ * An anchored regex only gets one search, so its stream runs the anchored DFA. Everything else runs the forward DFA
+ */
+static transition_table_t* stream_table(regex_t* regex){
+	if(regex->anchored_start == 1){
+		return (transition_table_t*)(regex->anchored_table);
+	}
+
+	return (transition_table_t*)(regex->forward_table);
+}
+
+
+/**
+ * Begin a brand new search at the stream's current position. If the empty string matches, we've found
+ * a match before we've even seen anything
+ */
+static void begin_stream_search(regex_stream_t* stream){
+	transition_table_t* table = stream_table(stream->regex);
+
+	stream->current_state = table_start(table);
+	stream->generation = table->generation;
+	stream->search_start = stream->position;
+	stream->match_start = stream->position;
+	stream->match_end = stream->position;
+	stream->found = (stream->current_state & TRANSITION_ACCEPTING) != 0;
+}
+
+
+/**
+ * If the stream's DFA is lazy, it may have been flushed since we last stepped it, either by this stream or by anything
+ * else that uses the same regex. If it was, the state that we saved is gone. Every byte since the search began is still in
+ * the history, so we'll just run them through again to find out where we are
+ */
+static void recover_stream_state(regex_stream_t* stream, const char* chunk, size_t chunk_offset){
+	transition_table_t* table = stream_table(stream->regex);
+
+	if(stream->generation == table->generation){
+		return;
+	}
+
+	stream->current_state = table_start(table);
+
+	for(size_t index = stream->search_start; index < stream->position; index++){
+		stream->current_state = table_transition(table, stream->current_state & TRANSITION_ROW_MASK, stream_byte(stream, chunk, chunk_offset, index));
+	}
+
+	stream->generation = table->generation;
+}
+
+
+/**
+ * Hand the match that the current search found over to the stream's callback, and begin the next search right where it
+ * ended. The reverse DFA tells us where the match starts, and every byte that it needs is still in the history or in the
+ * chunk. If the callback asks us to stop, we'll remember that
+ */
+static void report_stream_match(regex_stream_t* stream, const char* chunk, size_t chunk_offset){
+	regex_match_t match_struct;
+
+	//An anchored match can only start where the search did
+	stream->match_start = stream->search_start;
+
+	//Otherwise we read backwards from the end, just like find_match_start does
+	if(stream->regex->anchored_start == 0){
+		transition_table_t* table = (transition_table_t*)(stream->regex->reverse_table);
+		u_int32_t current_state = table_start(table);
+		stream->match_start = stream->match_end;
+
+		for(size_t index = stream->match_end; index > stream->search_start; index--){
+			current_state = table_transition(table, current_state & TRANSITION_ROW_MASK, stream_byte(stream, chunk, chunk_offset, index - 1));
+
+			if((current_state & TRANSITION_DEAD) != 0){
+				break;
+			}
+
+			if((current_state & TRANSITION_ACCEPTING) != 0){
+				stream->match_start = index - 1;
+			}
+		}
+	}
+
+	match_struct.match_start_idx = stream->match_start;
+	match_struct.match_end_idx = stream->match_end;
+	match_struct.status = MATCH_FOUND;
+
+	if(stream->callback(&match_struct, stream->user_data) != 0){
+		stream->stopped = 1;
+	}
+
+	//The next search starts where this one ended. If the match was empty, we need to step over
+	//one byte so that we're guaranteed to make progress
+	if(stream->match_end == stream->match_start){
+		stream->position = stream->match_end + 1;
+	} else {
+		stream->position = stream->match_end;
+	}
+
+	begin_stream_search(stream);
+
+	//An anchored regex only gets one search, right at the start
+	if(stream->regex->anchored_start == 1){
+		stream->stopped = 1;
+	}
+}
+
+
+/**
+ * Run the stream's DFA from its current position up to "end". This is the same scan that regex_find_all does, except
+ * that the bytes may be split between the history and the chunk, and that when we run out of bytes we can't tell if the
+ * match that we're in the middle of is over until "at_end" tells us that there's no more input coming. Returns the number
+ * of matches reported
+ */
+static size_t stream_scan(regex_stream_t* stream, const char* chunk, size_t chunk_offset, size_t end, u_int8_t at_end){
+	regex_t* regex = stream->regex;
+	transition_table_t* table = stream_table(regex);
+	u_int32_t next_state;
+	u_int8_t earliest = (regex->flags & REGEX_EARLIEST) != 0;
+	size_t num_reported = 0;
+
+	//Make sure that the state we saved is still good
+	recover_stream_state(stream, chunk, chunk_offset);
+
+	while(stream->stopped == 0){
+		//Earliest matches are reported the moment that they're found. A search that starts at the very end of the input
+		//doesn't count, so we'll wait for more to be sure that it isn't the end
+		if(stream->found == 1 && earliest == 1 && stream->search_start < end){
+			report_stream_match(stream, chunk, chunk_offset);
+			num_reported++;
+			continue;
+		}
+
+		if(stream->position >= end){
+			//If there's more coming, the match might keep going
+			if(at_end == 0){
+				break;
+			}
+
+			//There isn't, so whatever we've found is the match
+			if(stream->found == 0 || stream->search_start >= end){
+				break;
+			}
+
+			report_stream_match(stream, chunk, chunk_offset);
+			num_reported++;
+			continue;
+		}
+
+		//If we're sitting in the start state, nothing can begin until we see the first character of the literal prefix or a
+		//byte in the start set. We only look for the first character of the prefix, because the rest of it might not have been
+		//fed to us yet
+		if((stream->current_state & TRANSITION_START) != 0 && stream->found == 0 && stream->position >= chunk_offset){
+			const char* candidate;
+			size_t index = stream->position - chunk_offset;
+
+			if(regex->literal_prefix != NULL){
+				candidate = memchr(chunk + index, regex->literal_prefix[0], (end - chunk_offset) - index);
+			} else {
+				candidate = find_start_byte((start_set_t*)(regex->start_set), chunk + index, (end - chunk_offset) - index);
+			}
+
+			//If it isn't in what we have, we can skip all of it
+			if(candidate == NULL){
+				stream->position = end;
+				begin_stream_search(stream);
+				continue;
+			}
+
+			//Every byte that we skip over kills anything that was in progress, so if we skipped any, the search starts over
+			if(chunk_offset + (candidate - chunk) > stream->position){
+				stream->position = chunk_offset + (candidate - chunk);
+				begin_stream_search(stream);
+			}
+		}
+
+		next_state = table_transition(table, stream->current_state & TRANSITION_ROW_MASK, stream_byte(stream, chunk, chunk_offset, stream->position));
+
+		//A lazy DFA might have been flushed to make room for this state, in which case this is the only state that's any good
+		stream->generation = table->generation;
+
+		//If the DFA died, nothing can beat the match that we already have
+		if((next_state & TRANSITION_DEAD) != 0){
+			if(stream->found == 1){
+				report_stream_match(stream, chunk, chunk_offset);
+				num_reported++;
+			//Only an anchored search can die without a match, and it never gets another one
+			} else {
+				stream->stopped = 1;
+			}
+
+			continue;
+		}
+
+		stream->current_state = next_state;
+		stream->position++;
+
+		//Remember where this match ends
+		if((next_state & TRANSITION_ACCEPTING) != 0){
+			stream->found = 1;
+			stream->match_end = stream->position;
+		}
+	}
+
+	return num_reported;
+}
+
+
+/**
+ * Hold on to every byte of the chunk that the current search might need to read again, and let go of
+ * everything in the history that came before it
+ */
+static void save_stream_history(regex_stream_t* stream, const char* chunk, size_t chunk_offset){
+	size_t history_start = chunk_offset - stream->history_length;
+	size_t length = stream->offset - chunk_offset;
+	//Once we've stopped, we'll never need anything again
+	size_t keep_from = stream->stopped == 1 ? stream->offset : stream->search_start;
+
+	//Drop everything in the history that came before the current search
+	if(keep_from > history_start){
+		size_t drop = keep_from - history_start;
+
+		if(drop > stream->history_length){
+			drop = stream->history_length;
+		}
+
+		if(drop > 0){
+			memmove(stream->history, stream->history + drop, stream->history_length - drop);
+			stream->history_length -= drop;
 		}
 	}
 
-	//Display if desired
-	if(mode == REGEX_VERBOSE){
-		printf("DFA conversion succeeded.\n");
+	//Now add on the part of the chunk that we still need
+	size_t chunk_start = keep_from > chunk_offset ? keep_from - chunk_offset : 0;
+	if(chunk_start >= length){
+		return;
 	}
 
-	//If it did work, we'll set everything to true
-	regex->state = REGEX_VALID;
+	size_t needed = stream->history_length + (length - chunk_start);
 
-	//If the user request verbose mode, we'll display
-	if(mode == REGEX_VERBOSE){
-		printf("regex_t creation succeeded. Regex is now ready to be used.\n");
+	//Make room if we have to
+	if(needed > stream->history_capacity){
+		stream->history_capacity = needed * 2;
+		stream->history = realloc(stream->history, stream->history_capacity);
 	}
 
-	//If we make it here, we did a valid postfix, NFA and then NFA->DFA conversion, so
-	//the regex is all set
-	return regex;
+	memcpy(stream->history + stream->history_length, chunk + chunk_start, length - chunk_start);
+	stream->history_length = needed;
 }
 
 
 /**
- * A helper function that will simulate the running of the DFA to create matching //FIXME
+ * Initialize a streaming matcher. We start out in the DFA's start state at offset 0. Streams hold their place with the forward
+ * DFA, so a regex that doesn't have one can't be streamed, and we let the caller know
  */
-static void match(regex_match_t* match, regex_t* regex, char* string, u_int32_t starting_index, regex_mode_t mode){
-	//Advance the string pointer to be at the starting index the user asked for
-	char* match_string = string + starting_index;
+regex_state_t regex_stream_init(regex_stream_t* stream, regex_t* regex, regex_match_callback_t callback, void* user_data){
+	stream->regex = regex;
+	stream->offset = 0;
+	stream->position = 0;
+	stream->search_start = 0;
+	stream->match_start = 0;
+	stream->match_end = 0;
+	stream->found = 0;
+	stream->history = NULL;
+	stream->history_length = 0;
+	stream->history_capacity = 0;
+	stream->callback = callback;
+	stream->user_data = user_data;
+	stream->stopped = 0;
+	stream->current_state = 0;
+	stream->generation = 0;
+
+	//If we were given anything bad, this stream will never do anything
+	if(regex == NULL || regex->forward_table == NULL || regex->state == REGEX_ERR || callback == NULL){
+		stream->stopped = 1;
+		return REGEX_ERR;
+	}
 
-	//By default, we haven't found anything
-	match->status = MATCH_NOT_FOUND;
-	//Initialize this to the starting index
-	match->match_start_idx = starting_index;
-	//By default, these match meaning we don't have a match
-	match->match_end_idx = starting_index;
+	begin_stream_search(stream);
+
+	return REGEX_VALID;
+}
 
-	//Store a reference to the current state
-	DFA_state_t* start_state = (DFA_state_t*)(regex->DFA);
-	//By defualt, we are in the starting state
-	DFA_state_t* current_state = start_state;
 
-	char ch;
-	//The current index for the search
-	u_int32_t current_index = starting_index;
-	//Scan through the string
-	while((ch = *match_string) != '\0'){
-		//For each character, we'll attempt to advance using the transition list. If the transition list at that
-		//character does not=NULL(0, remember it was calloc'd), then we can advance. If it is 0, we'll reset the search
-		if(current_state->transitions[(u_int16_t)ch] != NULL){
-			//If we're in verbose mode, print this out
-			if(mode == REGEX_VERBOSE){
-				printf("Pattern continued/started with character: %c\n", ch);
+/**
+ * Feed the next chunk into the stream. The DFA state and the match that we're in the middle of live in the
+ * stream instead of on the stack, so the next chunk can pick up exactly where this one stopped
+ */
+size_t regex_stream_feed(regex_stream_t* stream, const char* chunk, size_t length){
+	//If we've been stopped, there's nothing to do
+	if(stream->stopped == 1 || chunk == NULL){
+		return 0;
+	}
+
+	size_t chunk_offset = stream->offset;
+	stream->offset += length;
+
+	size_t num_reported = stream_scan(stream, chunk, chunk_offset, stream->offset, 0);
+
+	//Save whatever we might need once the next chunk comes in
+	save_stream_history(stream, chunk, chunk_offset);
+
+	return num_reported;
+}
+
+
+/**
+ * There's no more input, so whatever the current search has found is its match. If that match ended before
+ * the input did, there's still more to search, and the history has every byte that we need
+ */
+size_t regex_stream_finish(regex_stream_t* stream){
+	size_t num_reported = 0;
+
+	if(stream->stopped == 0){
+		num_reported = stream_scan(stream, stream->history, stream->offset - stream->history_length, stream->offset, 1);
+	}
+
+	//No more input is allowed after this
+	stream->stopped = 1;
+
+	//We won't be needing any of this anymore
+	free(stream->history);
+	stream->history = NULL;
+	stream->history_length = 0;
+	stream->history_capacity = 0;
+
+	return num_reported;
+}
+
+
+/* ================================================== File Methods ================================================== */
+
+/**
+ * The callback used when the caller of regex_match_file only wants the count. The stream needs some callback to hand
+ * its matches to, and the count comes back from the stream itself
+ */
+static int count_file_match(regex_match_t* match, void* user_data){
+	(void)match;
+	(void)user_data;
+	return 0;
+}
+
+
+/**
+ * Read everything that's left in the file onto the heap. This is what we do with pipes, since we can't know how much is coming,
+ * and with anything else that can't be mapped. Returns the buffer, or NULL if the file couldn't be read
+ */
+static const char* read_whole_file(regex_file_t* file, int file_descriptor){
+	size_t capacity = FILE_READ_CHUNK;
+	size_t total = 0;
+	ssize_t bytes_read;
+	char* buffer = malloc(capacity);
+	char* grown;
+
+	if(buffer == NULL){
+		return NULL;
+	}
+
+	while(1){
+		//Make sure that there's always room for a full chunk
+		if(capacity - total < FILE_READ_CHUNK){
+			capacity *= 2;
+			grown = realloc(buffer, capacity);
+
+			if(grown == NULL){
+				free(buffer);
+				return NULL;
 			}
 
-			//Advance the current index
-			current_index++;
-			//We are in the start of a match, so we'll save the end state
-			match->match_end_idx = current_index;
+			buffer = grown;
+		}
+
+		bytes_read = read(file_descriptor, buffer + total, FILE_READ_CHUNK);
+
+		//Interrupted reads are just tried again
+		if(bytes_read < 0 && errno == EINTR){
+			continue;
+		}
+
+		//Anything else that goes wrong means we can't trust what we have
+		if(bytes_read < 0){
+			free(buffer);
+			return NULL;
+		}
+
+		//End of file
+		if(bytes_read == 0){
+			break;
+		}
+
+		total += bytes_read;
+	}
+
+	file->buffer = buffer;
+	file->length = total;
+	file->mapped = 0;
+
+	return buffer;
+}
+
+
+/**
+ * Map a regular file into memory so that it can be searched right where it is. Files smaller than FILE_MMAP_MIN_SIZE are
+ * cheaper to just read, and a file that's too large to map on this machine can't be. Returns 1 if the file was mapped
+ */
+static u_int8_t map_file(regex_file_t* file, int file_descriptor, struct stat* file_info){
+	if(S_ISREG(file_info->st_mode) == 0 || file_info->st_size < FILE_MMAP_MIN_SIZE || (u_int64_t)file_info->st_size > SIZE_MAX){
+		return 0;
+	}
+
+	void* buffer = mmap(NULL, file_info->st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+
+	if(buffer == MAP_FAILED){
+		return 0;
+	}
+
+	//We only ever read forward, so the kernel can read ahead aggressively and drop pages behind us
+	madvise(buffer, file_info->st_size, MADV_SEQUENTIAL);
+
+	file->buffer = buffer;
+	file->length = file_info->st_size;
+	file->mapped = 1;
+
+	return 1;
+}
+
+
+/**
+ * Load a whole file so that it can be searched all at once. Big regular files are mapped in, and everything else is read
+ * onto the heap
+ */
+const char* regex_load_file(regex_file_t* file, int file_descriptor){
+	struct stat file_info;
+
+	file->buffer = NULL;
+	file->length = 0;
+	file->mapped = 0;
+
+	if(fstat(file_descriptor, &file_info) != 0){
+		return NULL;
+	}
+
+	if(map_file(file, file_descriptor, &file_info) == 1){
+		return file->buffer;
+	}
+
+	return read_whole_file(file, file_descriptor);
+}
+
+
+/**
+ * Let go of a file that regex_load_file loaded, however it was loaded
+ */
+void regex_unload_file(regex_file_t* file){
+	if(file->buffer == NULL){
+		return;
+	}
+
+	if(file->mapped == 1){
+		munmap((void*)(file->buffer), file->length);
+	} else {
+		free((void*)(file->buffer));
+	}
+
+	file->buffer = NULL;
+	file->length = 0;
+	file->mapped = 0;
+}
+
+
+/**
+ * Read the file a chunk at a time and feed each chunk into a stream, so that the whole file never has to be in memory. Regular
+ * files are read with pread at the offset that we're at, and pipes with plain read. The chunks are page aligned so that the kernel
+ * can copy straight into them
+ */
+static size_t stream_file(regex_t* regex, int file_descriptor, u_int8_t seekable, regex_match_callback_t callback, void* user_data){
+	regex_stream_t stream;
+	size_t num_found = 0;
+	off_t offset = 0;
+	ssize_t bytes_read;
+	void* chunk;
+
+	if(posix_memalign(&chunk, FILE_READ_ALIGNMENT, FILE_READ_CHUNK) != 0){
+		return REGEX_FILE_ERR;
+	}
+
+	regex_stream_init(&stream, regex, callback, user_data);
+
+	//We can stop reading as soon as the callback tells us to
+	while(stream.stopped == 0){
+		if(seekable == 1){
+			bytes_read = pread(file_descriptor, chunk, FILE_READ_CHUNK, offset);
+		} else {
+			bytes_read = read(file_descriptor, chunk, FILE_READ_CHUNK);
+		}
+
+		//Interrupted reads are just tried again
+		if(bytes_read < 0 && errno == EINTR){
+			continue;
+		}
+
+		//If the read failed, we have to let the caller know
+		if(bytes_read < 0){
+			regex_stream_finish(&stream);
+			free(chunk);
+			return REGEX_FILE_ERR;
+		}
+
+		//End of file
+		if(bytes_read == 0){
+			break;
+		}
+
+		offset += bytes_read;
+		num_found += regex_stream_feed(&stream, chunk, bytes_read);
+	}
+
+	num_found += regex_stream_finish(&stream);
 
-			//Advance this up to be the next state
-			current_state = current_state->transitions[(u_int16_t)ch];
-		
-		//Go to the accepting state
-		} else if(current_state->transitions[ACCEPTING] != NULL){
-			//Advance to the accepting state
-			current_state = current_state->transitions[ACCEPTING];
+	free(chunk);
+	return num_found;
+}
+
+
+/**
+ * The public facing file matching method. Regular files that are big enough are mapped straight into memory and searched where
+ * they are, so nothing is ever copied. Everything else is read in chunks and streamed
+ */
+size_t regex_match_file(regex_t* regex, const char* path, regex_match_callback_t callback, void* user_data){
+	struct stat file_info;
+	regex_file_t file;
+	size_t num_found;
+
+	//If we are given a bad regex or no file, there's nothing to do
+	if(regex == NULL || regex->program == NULL || regex->state == REGEX_ERR || path == NULL){
+		return REGEX_FILE_ERR;
+	}
+
+	int file_descriptor = open(path, O_RDONLY);
+
+	if(file_descriptor < 0){
+		return REGEX_FILE_ERR;
+	}
+
+	if(fstat(file_descriptor, &file_info) != 0){
+		close(file_descriptor);
+		return REGEX_FILE_ERR;
+	}
+
+	u_int8_t regular = S_ISREG(file_info.st_mode) ? 1 : 0;
+	//Big regular files are mapped in, so we can search them right where they are
+	u_int8_t loaded = map_file(&file, file_descriptor, &file_info);
+
+	//A regex that has no forward DFA can't be streamed, so whatever is in the file has to be read in all at once
+	if(loaded == 0 && regex->forward_table == NULL){
+		if(read_whole_file(&file, file_descriptor) == NULL){
+			close(file_descriptor);
+			return REGEX_FILE_ERR;
+		}
+
+		loaded = 1;
+	}
+
+	if(loaded == 1){
+		close(file_descriptor);
+
+		if(callback == NULL){
+			num_found = regex_count(regex, file.buffer, file.length);
+		} else {
+			num_found = regex_find_all(regex, file.buffer, file.length, NULL, 0, callback, user_data);
+		}
+
+		regex_unload_file(&file);
+		return num_found;
+	}
+
+	//Otherwise we stream it
+	if(callback == NULL){
+		num_found = stream_file(regex, file_descriptor, regular, count_file_match, NULL);
+	} else {
+		num_found = stream_file(regex, file_descriptor, regular, callback, user_data);
+	}
+
+	close(file_descriptor);
+	return num_found;
+}
+
+
+/* ================================================== Regex Sets ================================================== */
+
+
+/**
+ * Build one DFA that recognizes every pattern in "patterns" at the same time. Each pattern is turned into
+ * its own NFA exactly like define_regular_expression does, and then all of the NFAs are fed into the subset
+ * construction together. The accepting states of each NFA remember which pattern they came from, so every
+ * state of the DFA knows which patterns have matched when we reach it
+ *
+ * If anything goes wrong, a regex_set_t struct will be returned in a REGEX_ERR state
+ */
+regex_set_t* define_regex_set(char** patterns, u_int32_t num_patterns, regex_mode_t mode){
+	//Allocate our set
+	regex_set_t* set = calloc(1, sizeof(regex_set_t));
+	set->num_patterns = num_patterns;
+	set->state = REGEX_ERR;
+
+	//Just in case
+	if(patterns == NULL || num_patterns == 0){
+		if(mode == REGEX_VERBOSE){
+			printf("REGEX SET ERROR: A regex set needs at least one pattern\n");
+		}
+
+		return set;
+	}
 
-			match->status = MATCH_FOUND;
+	set->postfix = calloc(num_patterns, sizeof(char*));
+	NFA_state_t** starts = calloc(num_patterns, sizeof(NFA_state_t*));
+	NFA_state_t* tail = NULL;
+	u_int32_t num_nfa_states = 0;
+	//Unanchored patterns' starts go at the front, and anchored ones fill in from the back
+	u_int32_t num_unanchored = 0;
+	u_int32_t num_anchored = 0;
+	u_int8_t anchored;
+	char* pattern;
+	regex_t pattern_regex;
+
+	//Compile every pattern down to an NFA
+	for(u_int32_t i = 0; i < num_patterns; i++){
+		pattern = patterns[i];
+
+		//Just like a regular regex, a leading ^ means this pattern can only match at the very start of the input
+		anchored = pattern != NULL && pattern[0] == '^';
+		if(anchored == 1){
+			pattern++;
+		}
 
+		//Same limits as a regular regex
+		if(pattern == NULL || strlen(pattern) == 0 || strlen(pattern) >= REGEX_LEN){
 			if(mode == REGEX_VERBOSE){
-				printf("Match found!\n");
+				printf("REGEX SET ERROR: Pattern %u is empty or too long\n", i);
 			}
 
-			return;
-		//Otherwise, we didn't find anything, so we need to reset
-		} else {
-			//Print out if we're in verbose mode
+			goto cleanup;
+		}
+
+		//Convert to postfix
+		set->postfix[i] = in_to_post(pattern, 0, mode);
+
+		if(set->postfix[i] == NULL){
 			if(mode == REGEX_VERBOSE){
-				printf("No pattern found for character: %c\n", ch);
+				printf("REGEX SET ERROR: Postfix conversion failed for pattern %u\n", i);
+			}
+
+			goto cleanup;
+		}
+
+		//Now make the NFA
+		memset(&pattern_regex, 0, sizeof(regex_t));
+		create_NFA(&pattern_regex, set->postfix[i], mode);
+
+		//Whether it worked or not, the chain goes on the end of our big chain so that it gets freed
+		if(pattern_regex.creation_chain != NULL){
+			if(tail == NULL){
+				set->creation_chain = pattern_regex.creation_chain;
+			} else {
+				tail->next_created = pattern_regex.creation_chain;
 			}
 
-			//Advance the current index
-			current_index++;
+			//The head of the chain is always the accepting state
+			((NFA_state_t*)(pattern_regex.creation_chain))->pattern_id = i;
 
-			//Reset these two parameters to reset the search
-			match->match_start_idx = current_index;
-			match->match_end_idx = current_index;
+			//Find the new tail
+			tail = pattern_regex.creation_chain;
+			while(tail->next_created != NULL){
+				tail = tail->next_created;
+			}
+		}
+
+		if(pattern_regex.NFA == NULL){
+			if(mode == REGEX_VERBOSE){
+				printf("REGEX SET ERROR: NFA creation failed for pattern %u\n", i);
+			}
 
-			//We are now back in the start state
-			current_state = start_state;
+			goto cleanup;
 		}
 
-		
-		//Push the pointer up
-		match_string++;
+		if(anchored == 1){
+			num_anchored++;
+			starts[num_patterns - num_anchored] = pattern_regex.NFA;
+		} else {
+			starts[num_unanchored] = pattern_regex.NFA;
+			num_unanchored++;
+		}
 	}
 
-	//Case that we have an "end match"
-	if(current_state->transitions[ACCEPTING] != NULL){
-		current_state = current_state->transitions[ACCEPTING];
-	}
+	//Every state across every NFA gets its own id
+	num_nfa_states = number_NFA_states(set->creation_chain, 0);
 
-	if(current_state->nfa_state_list.contains_accepting_state == 1){
-		//We've found the match
-		match->status = MATCH_FOUND;
+	//Now build the one DFA that does it all
+	set->DFA = subset_construction(starts, num_patterns, num_anchored, num_nfa_states, 1, 0);
 
+	if(set->DFA == NULL){
 		if(mode == REGEX_VERBOSE){
-			printf("Match found!\n");
+			printf("REGEX SET ERROR: DFA creation failed. The combined DFA needs more than %d states.\n", DFA_MAX_STATES);
 		}
 
-		return;
+		goto cleanup;
 	}
 
+	//Matching walks the flattened table, and only goes back to the states to see which patterns they accept
+	set->table = build_transition_table((DFA_state_t*)(set->DFA));
 
+	//If we make it here, everything worked
+	set->state = REGEX_VALID;
 
-	//If we end up here, that means that we ran off the end of the string and never found a match
-	//We'll set these flags and return if this is the case
-	match->match_end_idx = starting_index;
-	match->match_end_idx = starting_index;
-	match->status = MATCH_NOT_FOUND;
-	return;
+	if(mode == REGEX_VERBOSE){
+		printf("regex_set_t creation succeeded with %u patterns. Regex set is now ready to be used.\n", num_patterns);
+	}
+
+cleanup:
+	free(starts);
+	return set;
 }
 
 
 /**
- * The public facing match method that the user will call when attempting to pattern match
+ * Scan the buffer once, marking every pattern that matches anywhere in it. The DFA is unanchored, so it never needs to be
+ * reset. We walk its packed table, and only when we land on an accepting state do we look at which patterns it accepts
  */
-void regex_match(regex_t* regex, regex_match_t* match_struct, char* string, u_int32_t starting_index, regex_mode_t mode){
+u_int32_t regex_set_match(regex_set_t* set, const char* buffer, size_t length, u_int8_t* matched){
+	//Bad input means nothing matched
+	if(set == NULL || set->state == REGEX_ERR || matched == NULL){
+		return 0;
+	}
 
-	//Error mode by default
-	match_struct->status = MATCH_ERR;
+	//Nothing has matched yet
+	memset(matched, 0, set->num_patterns * sizeof(u_int8_t));
 
-	//If we are given a bad regex 
-	if(regex->DFA == NULL || regex->state == REGEX_ERR){
-		//Verbose mode
-		if(mode == REGEX_VERBOSE){
-			printf("REGEX ERROR: Attempt to use an invalid regex.\n");
+	transition_table_t* table = (transition_table_t*)(set->table);
+	const u_int32_t* transitions = table->transitions;
+	u_int32_t current_state = table_start(table);
+	u_int32_t num_matched = 0;
+	//The start state is always in row 0
+	size_t row = 0;
+
+	//Patterns that match the empty string match before we've read anything
+	if(buffer == NULL){
+		length = 0;
+	}
+
+	for(size_t current_index = 0; ; current_index++){
+		//Record any patterns that match here
+		if((current_state & TRANSITION_ACCEPTING) != 0){
+			DFA_state_t* accepting_state = table->states[row >> 8];
+
+			for(u_int32_t i = 0; i < accepting_state->num_accepted_patterns; i++){
+				if(matched[accepting_state->accepted_patterns[i]] == 0){
+					matched[accepting_state->accepted_patterns[i]] = 1;
+					num_matched++;
+				}
+			}
+
+			//If everything has matched, there's no point in going on
+			if(num_matched == set->num_patterns){
+				break;
+			}
 		}
 
-		//Pack in the values and return match.match_start = 0;
-		match_struct->match_start_idx = 0;
-		match_struct->match_end_idx = 0;
+		if(current_index >= length){
+			break;
+		}
 
-		//We return this value so that the caller can know what the error was
-		match_struct->status = MATCH_INV_INPUT;
+		current_state = transitions[row + (u_int8_t)buffer[current_index]];
 
-		//Give the regex back
-		return;
-	}
+		//Nearly every byte leads to a state that is neither accepting nor dead
+		if(current_state <= TRANSITION_ROW_MASK){
+			row = current_state;
+			continue;
+		}
 
-	//If we are given a bad string
-	if(string == NULL || strlen(string) == 0){
-		//Verbose mode
-		if(mode == REGEX_VERBOSE){
-			printf("REGEX ERROR: Attempt to match a NULL string or a string of length 0.\n");
+		//If every pattern is anchored, the DFA dies once none of them can match anymore
+		if((current_state & TRANSITION_DEAD) != 0){
+			break;
 		}
 
-		//Pack in the values and return
-		match_struct->match_start_idx = 0;
-		match_struct->match_end_idx = 0;
-		match_struct->status = MATCH_INV_INPUT;
+		row = current_state & TRANSITION_ROW_MASK;
+	}
+
+	return num_matched;
+}
+
+
+/**
+ * Deallocate all memory and destroy the regex set passed in
+ */
+void destroy_regex_set(regex_set_t* set){
+	if(set == NULL){
 		return;
 	}
 
-	//Attempt to match the string with the regex
-	match(match_struct, regex, string, starting_index, mode);
+	//Teardown every NFA, they're all in one chain
+	teardown_NFA((NFA_state_t*)(set->creation_chain));
 
-	//Return the match struct
-	return;
+	//Clean up the DFA and its table
+	teardown_DFA((DFA_state_t*)(set->DFA));
+	destroy_transition_table((transition_table_t*)(set->table));
+
+	//Free every postfix expression
+	for(u_int32_t i = 0; set->postfix != NULL && i < set->num_patterns; i++){
+		free(set->postfix[i]);
+	}
+
+	free(set->postfix);
+	free(set);
 }
 
 
@@ -1894,6 +6202,9 @@ static void teardown_DFA(DFA_state_t* state){
 		cursor = cursor->next;
 
 		//Free temp after we've advanced
+		free(temp->nfa_state_list.states);
+		free(temp->accepted_patterns);
+		free(temp->transitions);
 		free(temp);
 	}
 }
@@ -1908,13 +6219,40 @@ void destroy_regex(regex_t* regex){
 		//Teardown the NFA
 		teardown_NFA((NFA_state_t*)(regex->creation_chain));
 
-		//Clean up the DFA
-		teardown_DFA((DFA_state_t*)(regex->DFA));
+		//Clean up the DFAs
+		teardown_DFA((DFA_state_t*)(regex->anchored_DFA));
+		teardown_DFA((DFA_state_t*)(regex->forward_DFA));
+		teardown_DFA((DFA_state_t*)(regex->reverse_DFA));
+
+		//And their tables
+		destroy_transition_table((transition_table_t*)(regex->anchored_table));
+		destroy_transition_table((transition_table_t*)(regex->forward_table));
+		destroy_transition_table((transition_table_t*)(regex->reverse_table));
+
+		//And the Pike VM program and position automaton
+		destroy_pike_program((pike_program_t*)(regex->program));
+		destroy_glushkov((glushkov_t*)(regex->glushkov));
+		destroy_pike_program((pike_program_t*)(regex->capture_program));
 	}
 
 	//Free the postfix expression
 	free(regex->regex);
 
+	//Free the literal prefix and start set if we had them
+	free(regex->literal_prefix);
+	free(regex->start_set);
+
+	//Free the required factors if we had them
+	if(regex->required_factors != NULL){
+		required_factors_t* factors = (required_factors_t*)(regex->required_factors);
+
+		for(u_int32_t i = 0; i < factors->num_factors; i++){
+			free(factors->factors[i]);
+		}
+
+		free(factors);
+	}
+
 	//Free the regex itself
 	free(regex);
 }
@@ -26,10 +26,64 @@
 #define UPPERCASE 136
 //Define a-zA-Z
 #define LETTERS 137
+//Under REGEX_ICASE, every letter in the pattern is turned into one of these, which matches that letter in either case. The opt
+//is FOLDED_LETTER plus how far the letter is from 'a'
+#define FOLDED_LETTER 160
+//Marks the end of a capture group in the postfix that captures are built from. The group's number plus one comes right after it
+#define CAPTURE_GROUP 1
+//NFA states with an opt of at least this save where they are into capture slot opt - SAVE_SLOT. Every group has two slots,
+//one for where it starts and one for where it ends
+#define SAVE_SLOT 256
+//The most parenthesized groups that captures are reported for. Any after these are still there, they just aren't captured
+#define REGEX_MAX_GROUPS 32
+//Where a group that didn't take part in a match starts and ends
+#define REGEX_NO_GROUP SIZE_MAX
+//What regex_match_file returns if the file couldn't be opened or read
+#define REGEX_FILE_ERR SIZE_MAX
 //The maximum length of a regex is 150
 #define REGEX_LEN 150
 //This is the explicit concatenation character. It is used in place of actual concatenation
 #define CONCATENATION '`'
+//The number of inputs that the batch matcher keeps in flight at once
+#define BATCH_LANES 8
+//The most states that the subset construction will make for one DFA
+#define DFA_MAX_STATES 10000
+//The number of hash buckets the subset construction uses to find states that it has already made
+#define SUBSET_HASH_BUCKETS 4096
+//If more bytes than this can start a match, we won't bother skipping over the ones that can't
+#define START_SET_MAX_BYTES 64
+//The most ranges of bytes that the vectorized start byte search will check at once
+#define START_SET_MAX_RANGES 4
+//The most alternatives that a set of required literal factors can have, like {".com", ".edu"}
+#define REQUIRED_FACTOR_MAX_ALTERNATIVES 8
+//The longest required literal factor that we'll keep track of
+#define REQUIRED_FACTOR_MAX_LENGTH 32
+//regex_match_parallel never gives a thread less than this many bytes
+#define PARALLEL_MIN_CHUNK 65536
+//The most threads that regex_match_parallel will use
+#define PARALLEL_MAX_THREADS 64
+//The most states that a lazy DFA will hold at once before it throws them all out and starts over
+#define LAZY_DFA_MAX_STATES 1024
+//Once a lazy DFA has been flushed more than this many times, if it has made more than one state for every LAZY_DFA_MIN_BYTES_PER_STATE
+//bytes that it has searched, the DFA isn't helping and every search after that simulates the NFA instead
+#define LAZY_DFA_MAX_FLUSHES 4
+#define LAZY_DFA_MIN_BYTES_PER_STATE 8
+//Patterns with at most this many positions(characters, ranges and wildcards) have their NFA simulated a whole word at a time.
+//One more bit is needed for the state before anything has been consumed
+#define GLUSHKOV_MAX_POSITIONS 63
+//Regular files at least this big are mapped into memory by regex_match_file and regex_load_file. Anything smaller is cheaper to just read
+#define FILE_MMAP_MIN_SIZE 65536
+//How much regex_match_file and regex_load_file read at once when they can't map the file, and what streamed reads are aligned to
+#define FILE_READ_CHUNK 1048576
+#define FILE_READ_ALIGNMENT 4096
+//Packed DFA transitions keep the offset of the next state's row in their low bits and these flags in their high bits
+#define TRANSITION_DEAD 0x80000000
+#define TRANSITION_ACCEPTING 0x40000000
+#define TRANSITION_START 0x20000000
+//Lazy DFAs haven't worked out where this transition goes yet
+#define TRANSITION_UNKNOWN 0x10000000
+//Everything below the flags. A packed transition that is bigger than this has at least one flag set
+#define TRANSITION_ROW_MASK 0x0FFFFFFF
 
 #include <stdint.h>
 #include <sys/types.h>
@@ -72,6 +126,28 @@ typedef enum {
 } regex_mode_t;
 
 
+/**
+ * Flags that change how a regex is compiled. These can be OR'd together and handed to
+ * define_regular_expression_flags()
+ */
+typedef enum {
+	//The default. Report the match that starts first, and the longest match that starts there
+	REGEX_LEFTMOST_LONGEST = 0,
+	//Report the match that ends first, and stop scanning the moment that it's found
+	REGEX_EARLIEST = 1 << 0,
+	//Only make DFA states as the input needs them, and never hold more than LAZY_DFA_MAX_STATES of them at once. Every search
+	//can change the DFA, so a regex compiled with this must never be searched by more than one thread at a time
+	REGEX_LAZY = 1 << 1,
+	//Don't build any DFAs at all, and find every match by simulating the NFA with a Pike VM. Matching takes time proportional to
+	//the length of the input times the size of the pattern, but compiling is instant and the memory used never grows. Regexes
+	//that this is given to can't be streamed
+	REGEX_NFA = 1 << 2,
+	//Match letters without caring about their case. Both cases of a letter are folded together when the NFA is made, so every
+	//DFA already sends them to the same state, and searching costs exactly the same as it does without this
+	REGEX_ICASE = 1 << 3,
+} regex_flags_t;
+
+
 /**
  * A struct that contains all information needed for a regular expression
  */
@@ -80,23 +156,71 @@ typedef struct {
 	char* regex;
 	//The pointer to the NFA, the user should never touch this
 	void* NFA;
-	//The pointer to the DFA, the user should also never touch this
-	void* DFA;
+	//The pointer to the anchored DFA that is used for ^ and full matches, the user should also never touch this
+	void* anchored_DFA;
+	//The pointer to the unanchored DFA that finds where matches end, the user should also never touch this
+	void* forward_DFA;
+	//The pointer to the DFA that reads backwards from the end of a match to find its start, the user should also never touch this
+	void* reverse_DFA;
+	//The anchored, forward and reverse DFAs flattened into tables of packed transitions, the user should also never touch these
+	void* anchored_table;
+	void* forward_table;
+	void* reverse_table;
+	//The NFA flattened into a program for the Pike VM, the user should also never touch this
+	void* program;
+	//The pattern's position automaton for the bit-parallel matcher, or NULL if it has too many positions. The user should also never touch this
+	void* glushkov;
+	//The program that finds where every group matched, or NULL if there are no groups. The user should also never touch this
+	void* capture_program;
+	//How many parenthesized groups are captured
+	u_int32_t num_groups;
+	//The flags that the regex was compiled with
+	u_int32_t flags;
+	//Set if the pattern started with ^, meaning that a match can only begin at the very start of the input
+	u_int8_t anchored_start;
 	//The creation chain for the NFA
 	void* creation_chain;
+	//The literal string that every match must start with, or NULL if there isn't one
+	char* literal_prefix;
+	//The length of that literal string
+	u_int32_t literal_prefix_length;
+	//The set of bytes that can start a match, the user should never touch this
+	void* start_set;
+	//The literal strings that every match has to contain at least one of, the user should never touch this
+	void* required_factors;
 	//The state that the regex is in
 	regex_state_t state;
 } regex_t;
 
 
+/**
+ * A struct that contains all information needed for a set of regular expressions that
+ * are all matched at the same time
+ */
+typedef struct {
+	//The postfix form of every pattern
+	char** postfix;
+	//How many patterns are in the set
+	u_int32_t num_patterns;
+	//The pointer to the combined DFA, the user should never touch this
+	void* DFA;
+	//The combined DFA flattened into a table of packed transitions, the user should also never touch this
+	void* table;
+	//The creation chain for every NFA in the set
+	void* creation_chain;
+	//The state that the regex set is in
+	regex_state_t state;
+} regex_set_t;
+
+
 /**
  * A return type struct that allows for value packing by regex_match()
  */
 typedef struct {
 	//The pointer to the first match index
-	u_int32_t match_start_idx;
+	size_t match_start_idx;
 	//The pointer to the end of the match
-	u_int32_t match_end_idx;
+	size_t match_end_idx;
 	//The match status
 	match_status_t status;
 
@@ -104,11 +228,150 @@ typedef struct {
 
 
 /**
- * Define a regular expression using all regular expression rules
+ * Where one parenthesized group matched. Groups that didn't take part in the match start and end
+ * at REGEX_NO_GROUP
+ */
+typedef struct {
+	size_t start;
+	size_t end;
+} regex_group_t;
+
+
+/**
+ * A match along with where every group in it matched. This is filled in by regex_match_captures()
+ */
+typedef struct {
+	//Group 0 is the whole match, and group i is the group opened by the i-th opening parenthesis
+	regex_group_t groups[REGEX_MAX_GROUPS + 1];
+	//How many groups the regex has, not counting the whole match
+	u_int32_t num_groups;
+	//The match status
+	match_status_t status;
+} regex_captures_t;
+
+
+/**
+ * A length delimited piece of input, used when handing many inputs to the
+ * library at once
+ */
+typedef struct {
+	//The start of the input
+	const char* buffer;
+	//How many bytes are in it
+	size_t length;
+} regex_span_t;
+
+
+/**
+ * A callback that can be handed to the find all functions. It is invoked once for every match
+ * that is found, in order. Returning anything other than 0 will stop the search early
+ */
+typedef int (*regex_match_callback_t)(regex_match_t* match, void* user_data);
+
+
+/**
+ * A line that has a match in it, as reported by regex_match_lines(). The line runs from line_start up to
+ * line_end, which is the index of its newline(or the end of the buffer), so the newline is never included
+ */
+typedef struct {
+	//Which line this is, counting from 1
+	size_t line_number;
+	size_t line_start;
+	size_t line_end;
+} regex_line_t;
+
+
+/**
+ * A callback that is invoked once for every line that matches, in order. Returning anything other
+ * than 0 will stop the search early
+ */
+typedef int (*regex_line_callback_t)(regex_line_t* line, void* user_data);
+
+
+/**
+ * An iterator that walks over every non-overlapping match in a buffer in one
+ * forward pass. The user should initialize this with regex_iter_init() and never
+ * modify it directly
+ */
+typedef struct {
+	//The regex we are matching with
+	regex_t* regex;
+	//The buffer that we're walking over
+	const char* buffer;
+	//The length of that buffer
+	size_t length;
+	//Where the next search will pick up
+	size_t position;
+} regex_iter_t;
+
+
+/**
+ * A streaming matcher that can be fed its input one chunk at a time. Everything that is needed to pick up
+ * where the last chunk left off is kept in here, so matches that cross chunk boundaries are still found. The
+ * user should initialize this with regex_stream_init() and never modify it directly
+ */
+typedef struct {
+	//The regex we are matching with
+	regex_t* regex;
+	//The packed DFA state that we're currently in
+	u_int32_t current_state;
+	//If the DFA is lazy, how many times it had been flushed when we got to that state
+	u_int32_t generation;
+	//The absolute offset of the next byte that we'll be fed
+	size_t offset;
+	//The absolute offset of the next byte that the DFA will step over
+	size_t position;
+	//Where the current search began. No match that is still in progress can start before this
+	size_t search_start;
+	//The start and end of the match that we're in the middle of
+	size_t match_start;
+	size_t match_end;
+	//Set once the current search has accepted somewhere
+	u_int8_t found;
+	//Every byte from search_start up to offset that came in an earlier chunk. We may need to read these again to
+	//find where a match starts, or to begin the next search
+	char* history;
+	size_t history_length;
+	size_t history_capacity;
+	//Every match is handed to this callback
+	regex_match_callback_t callback;
+	void* user_data;
+	//Set once the callback asks us to stop, or if the stream is invalid
+	u_int8_t stopped;
+} regex_stream_t;
+
+
+/**
+ * The whole contents of a file, loaded by regex_load_file(). The user should never modify this directly,
+ * and must give it back with regex_unload_file() once they're done searching it
+ */
+typedef struct {
+	//Every byte of the file. This is not null terminated
+	const char* buffer;
+	size_t length;
+	//Set if the file was mapped into memory instead of read onto the heap
+	u_int8_t mapped;
+} regex_file_t;
+
+
+/**
+ * Define a regular expression using all regular expression rules. The regex that comes back can be searched by
+ * any number of threads at once
  */
 regex_t* define_regular_expression(char* pattern, regex_mode_t mode);
 
 
+/**
+ * Define a regular expression with the compile flags in "flags"(see regex_flags_t). Calling this with
+ * REGEX_LEFTMOST_LONGEST is the same as calling define_regular_expression()
+ *
+ * Regexes that were compiled with REGEX_LAZY change as they are searched, so they can't be shared between threads. Every other
+ * regex, including one that had to fall back to simulating its NFA, is never written to after it's defined, and any number of
+ * threads can search it at once
+ */
+regex_t* define_regular_expression_flags(char* pattern, regex_mode_t mode, u_int32_t flags);
+
+
 /**
  * Determine whether or not a string belongs to the regular language defined by 
  * the DFA in regex_t.
@@ -117,9 +380,173 @@ regex_t* define_regular_expression(char* pattern, regex_mode_t mode);
 void regex_match(regex_t* regex, regex_match_t* match_struct, char* string, u_int32_t starting_index, regex_mode_t mode);
 
 
+/**
+ * Length delimited version of regex_match. Exactly "length" bytes of "buffer" are scanned starting at
+ * "starting_index", and the buffer does not need to be null terminated. Any byte value may appear in 
+ * the buffer, but only printable characters can ever be part of a match
+ */
+void regex_match_n(regex_t* regex, regex_match_t* match_struct, const char* buffer, size_t length, size_t starting_index, regex_mode_t mode);
+
+
+/**
+ * Determine whether all "length" bytes of "buffer" belong to the regular language, as opposed to just some piece of it.
+ * The search stops at the very first byte that can't be part of a match, so bad input is rejected as early as possible.
+ * An empty buffer is allowed here, and it's a match if the regex can match the empty string
+ */
+void regex_fullmatch(regex_t* regex, regex_match_t* match_struct, const char* buffer, size_t length, regex_mode_t mode);
+
+
+/**
+ * Determine whether there is a match anywhere in the first "length" bytes of "buffer", without finding out where it is.
+ * The search stops at the very first place that any match ends, so this is faster than regex_match_n. Returns MATCH_FOUND
+ * or MATCH_NOT_FOUND, or MATCH_INV_INPUT if the regex or buffer is bad
+ */
+match_status_t regex_is_match(regex_t* regex, const char* buffer, size_t length);
+
+
+/**
+ * Find the same match that regex_match_n would, along with where every parenthesized group in it matched. When a group could
+ * have matched in more than one way, repetition takes as much as it can and alternation takes its left side first. Groups
+ * inside of a repetition report the last time that they matched
+ */
+void regex_match_captures(regex_t* regex, regex_captures_t* captures, const char* buffer, size_t length, size_t starting_index, regex_mode_t mode);
+
+
+/**
+ * Find out which of "num_regexes" regexes match anywhere in the buffer, reading it once for every BATCH_LANES regexes instead of
+ * once for each one. matched[i] is set to 1 if regexes[i] matched and 0 if it didn't, so it must have room for every regex.
+ * Returns the number of regexes that matched
+ */
+u_int32_t regex_match_lockstep(regex_t** regexes, u_int32_t num_regexes, const char* buffer, size_t length, u_int8_t* matched);
+
+
+/**
+ * Search one large buffer for the same match that regex_match_n would find from index 0, using up to "num_threads" threads.
+ * The buffer is cut into one chunk per thread and the chunks are scanned at the same time, so this pays off on buffers that
+ * are many megabytes long. Small buffers, anchored regexes and regexes that match the empty string are scanned on the calling thread
+ */
+void regex_match_parallel(regex_t* regex, regex_match_t* match_struct, const char* buffer, size_t length, u_int32_t num_threads, regex_mode_t mode);
+
+
+/**
+ * Match every one of the "num_inputs" inputs against the same regex. This is the same as calling regex_match_n on each one of
+ * them, but several inputs are run through the DFA at once so that their state lookups overlap. The result for inputs[i] is
+ * stored in results[i]
+ */
+void regex_match_batch(regex_t* regex, const regex_span_t* inputs, size_t num_inputs, regex_match_t* results);
+
+
+/**
+ * Initialize an iterator over every non-overlapping match of "regex" in "buffer"
+ */
+void regex_iter_init(regex_iter_t* iter, regex_t* regex, const char* buffer, size_t length);
+
+
+/**
+ * Find the next match for the iterator. The match is packed into "match_struct" and the status
+ * is also returned, so that the user can loop until it is no longer MATCH_FOUND
+ */
+match_status_t regex_iter_next(regex_iter_t* iter, regex_match_t* match_struct);
+
+
+/**
+ * Find every non-overlapping match in the buffer in one forward pass. Matches are written into "matches"(up to
+ * "max_matches" of them) if it is not NULL, and handed to "callback" if it is not NULL. Returns the number of matches
+ * found
+ */
+size_t regex_find_all(regex_t* regex, const char* buffer, size_t length, regex_match_t* matches, size_t max_matches, regex_match_callback_t callback, void* user_data);
+
+
+/**
+ * Count every non-overlapping match in the buffer. The count is the same one that regex_find_all would return, but
+ * no match positions are ever worked out
+ */
+size_t regex_count(regex_t* regex, const char* buffer, size_t length);
+
+
+/**
+ * Find every line in the buffer that has a match in it, handing each one to "callback". Lines are separated by '\n', and a
+ * pattern that starts with ^ only matches at the start of a line. If the callback is NULL, the lines are only counted. Returns
+ * the number of lines that matched
+ */
+size_t regex_match_lines(regex_t* regex, const char* buffer, size_t length, regex_line_callback_t callback, void* user_data);
+
+
+/**
+ * Initialize a streaming matcher. Every match that is found is handed to "callback", with offsets
+ * that are relative to the very first byte ever fed to the stream. Returns REGEX_VALID if the stream is
+ * ready, or REGEX_ERR if the regex is invalid, the callback is NULL, or the regex has no DFA to stream
+ * with(it was compiled with REGEX_NFA, or its DFA couldn't be built). A stream that returned REGEX_ERR
+ * never reports anything, but regex_stream_finish must still be called on it
+ */
+regex_state_t regex_stream_init(regex_stream_t* stream, regex_t* regex, regex_match_callback_t callback, void* user_data);
+
+
+/**
+ * Feed the next "length" bytes of input into the stream. Returns the number of matches that were
+ * reported while scanning this chunk. If regex_stream_init returned REGEX_ERR, this does nothing
+ * and always returns 0
+ */
+size_t regex_stream_feed(regex_stream_t* stream, const char* chunk, size_t length);
+
+
+/**
+ * Let the stream know that there is no more input coming. A match that runs all the way to the end
+ * of the input can only be reported here. This also frees everything the stream was holding on to, so
+ * it must always be called. Returns the number of matches reported
+ */
+size_t regex_stream_finish(regex_stream_t* stream);
+
+
+/**
+ * Find every non-overlapping match in the file at "path", handing each one to "callback" with offsets from the start of the file.
+ * Regular files are mapped into memory and searched in place, and everything else(pipes, small files) is read in chunks and
+ * streamed. If the callback is NULL, the matches are only counted. Returns the number of matches found, or REGEX_FILE_ERR if
+ * the regex is invalid or the file couldn't be opened or read
+ */
+size_t regex_match_file(regex_t* regex, const char* path, regex_match_callback_t callback, void* user_data);
+
+
+/**
+ * Load everything in "file_descriptor" into "file", so that it can be handed to any of the match functions all at once. Regular
+ * files of at least FILE_MMAP_MIN_SIZE bytes are mapped into memory, and everything else(pipes, standard input, small files) is read
+ * onto the heap. The file descriptor is left open, and can be closed right away. Returns the loaded buffer, or NULL if the file
+ * couldn't be read, in which case errno says why
+ */
+const char* regex_load_file(regex_file_t* file, int file_descriptor);
+
+
+/**
+ * Free or unmap a file that was loaded with regex_load_file()
+ */
+void regex_unload_file(regex_file_t* file);
+
+
 /**
  * Deallocate all memory and destroy the regex passed in
  */
 void destroy_regex(regex_t* regex);
 
+
+/**
+ * Define a set of regular expressions that are all compiled into one DFA. Scanning with the set
+ * looks for every pattern at once, so each byte is only read one time no matter how many patterns
+ * there are
+ */
+regex_set_t* define_regex_set(char** patterns, u_int32_t num_patterns, regex_mode_t mode);
+
+
+/**
+ * Scan "length" bytes of "buffer" once and find out which patterns in the set match anywhere in it.
+ * matched[i] is set to 1 if pattern i matched and 0 if it didn't, so it must have room for every pattern.
+ * Returns the number of patterns that matched
+ */
+u_int32_t regex_set_match(regex_set_t* set, const char* buffer, size_t length, u_int8_t* matched);
+
+
+/**
+ * Deallocate all memory and destroy the regex set passed in
+ */
+void destroy_regex_set(regex_set_t* set);
+
 #endif
@@ -0,0 +1,276 @@
+/**
+ * Author: Jack Robbins
+ * This is a benchmark for the matching loops in the regex library. It builds one large buffer of
+ * text and times every way that there is to search it. Searches that have to get through the whole
+ * buffer also report how many megabytes per second they manage. Every search is done silently, since
+ * that's the path that matters for speed. Run it with "modes" to instead time REGEX_SILENT against
+ * REGEX_VERBOSE, which shows what tracing costs and that silent searches never pay for it
+ */
+
+#include "regex/regex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+//Just for timing
+#include <time.h>
+
+//How big the buffer that we search is
+#define BENCHMARK_BYTES (64 * 1024 * 1024)
+//How many times each search is run. We report the fastest one
+#define BENCHMARK_ROUNDS 5
+//Verbose searches print a line for every byte, so the mode comparison only searches this much off the end of the buffer
+#define MODE_BENCHMARK_BYTES (1024 * 1024)
+
+
+/**
+ * The patterns that we benchmark, along with what they're meant to stress
+ */
+typedef struct {
+	char* pattern;
+	char* description;
+} benchmark_pattern_t;
+
+
+/**
+ * Get the current time in seconds
+ */
+static double now(){
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+
+/**
+ * Fill the buffer with lowercase words and numbers separated by spaces. The only '@' and '.' in the
+ * whole buffer are right at the end, so anything that needs one has to scan all of it
+ */
+static void fill_buffer(char* buffer, size_t length){
+	//A fixed seed so that every run sees the same text
+	srand(1);
+
+	for(size_t i = 0; i < length; i++){
+		buffer[i] = "abcdefghijklmnop qrstuvwxyz 0123456789"[rand() % 38];
+	}
+
+	memcpy(buffer + length - 25, "see robbins.com for jack@", 25);
+}
+
+
+/**
+ * Print out the time for the fastest of the rounds. If the search went through the whole buffer,
+ * we'll also print out how fast it did that
+ */
+static void report(char* name, double best, size_t result, u_int8_t whole_buffer){
+	printf("\t%-18s %10.3f ms", name, best * 1000.0);
+
+	if(whole_buffer == 1){
+		printf(" %9.1f MB/s", (BENCHMARK_BYTES / (1024.0 * 1024.0)) / best);
+	} else {
+		printf("              ");
+	}
+
+	printf("   (result: %zu)\n", result);
+}
+
+
+/**
+ * Run every search on the same regex and report how fast each one is
+ */
+static void run_benchmark(benchmark_pattern_t* benchmark, char* buffer){
+	regex_t* regex = define_regular_expression(benchmark->pattern, REGEX_SILENT);
+	regex_match_t match;
+	double start;
+	double elapsed;
+	double best;
+	size_t result = 0;
+
+	printf("REGEX: '%s' -- %s\n", benchmark->pattern, benchmark->description);
+
+	if(regex->state != REGEX_VALID){
+		printf("\tRegex is invalid, skipping\n\n");
+		destroy_regex(regex);
+		return;
+	}
+
+	//The first match, with its start and end
+	best = 1e9;
+	for(u_int32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+		start = now();
+		regex_match_n(regex, &match, buffer, BENCHMARK_BYTES, 0, REGEX_SILENT);
+		elapsed = now() - start;
+		best = elapsed < best ? elapsed : best;
+	}
+
+	//If the first match ends at the end of the buffer, we had to scan all of it
+	result = match.status == MATCH_FOUND ? match.match_end_idx - match.match_start_idx : 0;
+	report("regex_match_n", best, result, match.status != MATCH_FOUND || match.match_end_idx > BENCHMARK_BYTES - 32);
+
+	//Just whether there's a match
+	best = 1e9;
+	for(u_int32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+		start = now();
+		result = regex_is_match(regex, buffer, BENCHMARK_BYTES) == MATCH_FOUND;
+		elapsed = now() - start;
+		best = elapsed < best ? elapsed : best;
+	}
+
+	report("regex_is_match", best, result, result == 0);
+
+	//Every match, with its start and end
+	best = 1e9;
+	for(u_int32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+		regex_iter_t iter;
+		result = 0;
+
+		start = now();
+		regex_iter_init(&iter, regex, buffer, BENCHMARK_BYTES);
+		while(regex_iter_next(&iter, &match) == MATCH_FOUND){
+			result++;
+		}
+		elapsed = now() - start;
+		best = elapsed < best ? elapsed : best;
+	}
+
+	report("regex_iter_next", best, result, 1);
+
+	//Just how many matches there are
+	best = 1e9;
+	for(u_int32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+		start = now();
+		result = regex_count(regex, buffer, BENCHMARK_BYTES);
+		elapsed = now() - start;
+		best = elapsed < best ? elapsed : best;
+	}
+
+	report("regex_count", best, result, 1);
+
+	printf("\n");
+
+	destroy_regex(regex);
+}
+
+
+/**
+ * Find every match in the last MODE_BENCHMARK_BYTES of the buffer with regex_match_n in one mode, sending anything that it
+ * prints to "null_descriptor". Every byte gets searched this way, no matter how soon the first match is. Returns the fastest
+ * round, and the number of matches in "result"
+ */
+static double time_mode(regex_t* regex, char* buffer, regex_mode_t mode, int null_descriptor, size_t* result){
+	//The end of the buffer is where the '@' and the ".com" are
+	char* slice = buffer + BENCHMARK_BYTES - MODE_BENCHMARK_BYTES;
+	regex_match_t match;
+	size_t current_index;
+	double start;
+	double elapsed;
+	double best = 1e9;
+
+	//Anything that the search prints goes nowhere, so we only time the search and not the terminal
+	fflush(stdout);
+	int saved_stdout = dup(STDOUT_FILENO);
+	dup2(null_descriptor, STDOUT_FILENO);
+
+	for(u_int32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+		*result = 0;
+		current_index = 0;
+
+		start = now();
+		while(current_index < MODE_BENCHMARK_BYTES){
+			regex_match_n(regex, &match, slice, MODE_BENCHMARK_BYTES, current_index, mode);
+
+			if(match.status != MATCH_FOUND){
+				break;
+			}
+
+			(*result)++;
+			//An empty match still has to move us forward
+			current_index = match.match_end_idx > match.match_start_idx ? match.match_end_idx : match.match_end_idx + 1;
+		}
+		fflush(stdout);
+		elapsed = now() - start;
+		best = elapsed < best ? elapsed : best;
+	}
+
+	dup2(saved_stdout, STDOUT_FILENO);
+	close(saved_stdout);
+
+	return best;
+}
+
+
+/**
+ * Time the same search with REGEX_SILENT and with REGEX_VERBOSE. The mode is only checked once per search, so the silent
+ * numbers here should be the same as the ones from a normal run
+ */
+static void run_mode_benchmark(benchmark_pattern_t* benchmark, char* buffer, int null_descriptor){
+	regex_t* regex = define_regular_expression(benchmark->pattern, REGEX_SILENT);
+
+	printf("REGEX: '%s' -- %s\n", benchmark->pattern, benchmark->description);
+
+	if(regex->state != REGEX_VALID){
+		printf("\tRegex is invalid, skipping\n\n");
+		destroy_regex(regex);
+		return;
+	}
+
+	size_t silent_result;
+	size_t verbose_result;
+	double silent = time_mode(regex, buffer, REGEX_SILENT, null_descriptor, &silent_result);
+	double verbose = time_mode(regex, buffer, REGEX_VERBOSE, null_descriptor, &verbose_result);
+
+	printf("\t%-18s %10.3f ms   (result: %zu)\n", "REGEX_SILENT", silent * 1000.0, silent_result);
+	printf("\t%-18s %10.3f ms   (result: %zu, %.1fx slower)\n\n", "REGEX_VERBOSE", verbose * 1000.0, verbose_result, verbose / silent);
+
+	destroy_regex(regex);
+}
+
+
+/**
+ * Run every benchmark. Passing "modes" compares the silent and verbose searches instead
+ */
+int main(int argc, char** argv){
+	benchmark_pattern_t benchmarks[] = {
+		{"[a-z]+", "lots of short matches"},
+		{"[0-9]+ [a-z]+", "matches that often start and then fail"},
+		{"$+@", "one match that covers the whole buffer"},
+		{"([a-z]+ )+[a-z]+.com", "long partial matches with a required factor"},
+		{"q(u|v)*z", "rare matches found by skipping ahead"},
+	};
+
+	char* buffer = malloc(BENCHMARK_BYTES);
+	fill_buffer(buffer, BENCHMARK_BYTES);
+
+	if(argc == 2 && strcmp(argv[1], "modes") == 0){
+		int null_descriptor = open("/dev/null", O_WRONLY);
+
+		if(null_descriptor < 0){
+			printf("Could not open /dev/null\n");
+			free(buffer);
+			return 1;
+		}
+
+		printf("Finding every match in %d MB of text with regex_match_n in each mode, best of %d rounds. Verbose output goes to /dev/null\n\n", MODE_BENCHMARK_BYTES / (1024 * 1024), BENCHMARK_ROUNDS);
+
+		for(u_int32_t i = 0; i < sizeof(benchmarks) / sizeof(benchmark_pattern_t); i++){
+			run_mode_benchmark(&(benchmarks[i]), buffer, null_descriptor);
+		}
+
+		close(null_descriptor);
+		free(buffer);
+
+		return 0;
+	}
+
+	printf("Searching %d MB of text, best of %d rounds\n\n", BENCHMARK_BYTES / (1024 * 1024), BENCHMARK_ROUNDS);
+
+	for(u_int32_t i = 0; i < sizeof(benchmarks) / sizeof(benchmark_pattern_t); i++){
+		run_benchmark(&(benchmarks[i]), buffer);
+	}
+
+	free(buffer);
+
+	return 0;
+}
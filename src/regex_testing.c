@@ -5,12 +5,42 @@
 
 #include "regex/regex.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 //Just for timing
 #include <time.h>
 
 
+/**
+ * A callback for the find all tests that just prints out what it's given
+ */
+int print_match_callback(regex_match_t* match, void* user_data){
+	//We'll count how many times we've been called
+	u_int32_t* times_called = (u_int32_t*)user_data;
+	(*times_called)++;
+
+	printf("Callback match starts at index: %zu and ends at index:%zu\n", match->match_start_idx, match->match_end_idx);
+
+	//Keep going
+	return 0;
+}
+
+
+/**
+ * A callback for the line matching tests that prints out every line that it's given
+ */
+int print_line_callback(regex_line_t* line, void* user_data){
+	const char* buffer = (const char*)user_data;
+
+	printf("Line %zu matched: %.*s\n", line->line_number, (int)(line->line_end - line->line_start), buffer + line->line_start);
+
+	//Keep going
+	return 0;
+}
+
+
 /**
 * Define a testing function for us here. "test_case" is what case we want to test, and fall through
 * let's us know that we want to test everything after that case
@@ -19,6 +49,7 @@ void test_case_run(u_int8_t test_case){
 	char* test_string;
 	regex_t* tester;
 	regex_match_t matcher;
+	u_int32_t times_called;
 
 	//Go through all of our test cases. Designed so that we can always add more
 	switch(test_case){
@@ -280,7 +311,7 @@ void test_case_run(u_int8_t test_case){
 
 			regex_match(tester, &matcher, test_string, 0, REGEX_VERBOSE);
 
-			//This should not match 
+			//This should match "dabc" at 10..14, which starts inside of the partial match "abda"
 			test_string = "asfdasdfabdabcda";
 			printf("TEST STRING: %s\n\n", test_string);
 
@@ -673,7 +704,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -687,7 +718,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -715,7 +746,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -729,7 +760,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -754,7 +785,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -780,7 +811,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -794,7 +825,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -821,7 +852,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -848,7 +879,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -862,7 +893,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -890,7 +921,7 @@ void test_case_run(u_int8_t test_case){
 	
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -915,7 +946,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -939,7 +970,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -952,7 +983,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -976,7 +1007,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1001,7 +1032,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1014,7 +1045,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1027,7 +1058,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1052,7 +1083,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1075,7 +1106,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1099,7 +1130,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1123,7 +1154,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1147,7 +1178,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1160,7 +1191,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1184,7 +1215,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1197,7 +1228,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1221,7 +1252,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1234,7 +1265,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1258,7 +1289,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1271,7 +1302,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1295,7 +1326,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1308,7 +1339,7 @@ void test_case_run(u_int8_t test_case){
 			
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1332,7 +1363,7 @@ void test_case_run(u_int8_t test_case){
 	
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1356,7 +1387,7 @@ void test_case_run(u_int8_t test_case){
 	
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1380,7 +1411,7 @@ void test_case_run(u_int8_t test_case){
 	
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1405,7 +1436,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1418,7 +1449,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1442,7 +1473,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1455,7 +1486,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1479,7 +1510,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1492,7 +1523,7 @@ void test_case_run(u_int8_t test_case){
 			
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1516,7 +1547,7 @@ void test_case_run(u_int8_t test_case){
 	
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1529,7 +1560,7 @@ void test_case_run(u_int8_t test_case){
 	
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1553,7 +1584,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1566,7 +1597,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -1982,7 +2013,7 @@ void test_case_run(u_int8_t test_case){
 
 			//Display if we've found a match
 			if(matcher.status == MATCH_FOUND){
-				printf("Match starts at index: %d and ends at index:%d\n", matcher.match_start_idx, matcher.match_end_idx);
+				printf("Match starts at index: %zu and ends at index:%zu\n", matcher.match_start_idx, matcher.match_end_idx);
 			} else {
 				printf("No match.\n\n");
 			}
@@ -2237,6 +2268,849 @@ void test_case_run(u_int8_t test_case){
 				
 			return;
 
+		case 81:
+			printf("Testing length delimited matching\n");
+			printf("REGEX: 'abcd'\n");
+
+			tester = define_regular_expression("abcd", REGEX_SILENT);
+
+			//A buffer with an embedded null byte and no terminator in the slice that we scan
+			char buffer[] = {'x', 'y', '\0', 'z', 'a', 'b', 'c', 'd', 'e', 'f'};
+			printf("TEST BUFFER: xy\\0zabcdef (10 bytes)\n\n");
+
+			//We should match here, straight past the null byte
+			regex_match_n(tester, &matcher, buffer, sizeof(buffer), 0, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			//Only look at the first 7 bytes -- should fail
+			printf("TEST BUFFER: first 7 bytes only\n\n");
+			regex_match_n(tester, &matcher, buffer, 7, 0, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			destroy_regex(tester);
+
+			return;
+
+		case 82:
+			printf("Testing find all and iterators\n");
+			printf("REGEX: 'a(bc)+'\n");
+
+			tester = define_regular_expression("a(bc)+", REGEX_SILENT);
+
+			test_string = "abcxxabcbcyyabc-abd";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			//Walk through with an iterator
+			regex_iter_t iter;
+			regex_iter_init(&iter, tester, test_string, strlen(test_string));
+
+			while(regex_iter_next(&iter, &matcher) == MATCH_FOUND){
+				printf("Match starts at index: %zu and ends at index:%zu\n", matcher.match_start_idx, matcher.match_end_idx);
+			}
+
+			//Now do it all at once into an array
+			regex_match_t matches[5];
+			size_t num_found = regex_find_all(tester, test_string, strlen(test_string), matches, 5, NULL, NULL);
+			printf("\nFound %zu matches with regex_find_all\n", num_found);
+
+			//And once more with a callback
+			times_called = 0;
+			regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called);
+			printf("Callback was called %u times\n\n", times_called);
+
+			destroy_regex(tester);
+
+			return;
+
+		case 83:
+			printf("Testing batch matching\n");
+			printf("REGEX: '$+.txt'\n");
+
+			tester = define_regular_expression("$+.txt", REGEX_SILENT);
+
+			//A whole batch of filenames, some of which should fail
+			char* filenames[] = {"fname.txt", "notes.md", "a.txt", "", "archive.tar.gz", "report_final.txt", ".txt", "x.txt",
+								 "main.c", "data.txt.bak", "readme.txt"};
+			size_t num_filenames = sizeof(filenames) / sizeof(char*);
+			regex_span_t inputs[11];
+			regex_match_t results[11];
+
+			for(size_t i = 0; i < num_filenames; i++){
+				inputs[i].buffer = filenames[i];
+				inputs[i].length = strlen(filenames[i]);
+			}
+
+			regex_match_batch(tester, inputs, num_filenames, results);
+
+			for(size_t i = 0; i < num_filenames; i++){
+				printf("TEST STRING: %s\n", filenames[i]);
+
+				//Display if we've found a match
+				if(results[i].status == MATCH_FOUND){
+					printf("Match starts at index: %zu and ends at index:%zu\n\n", results[i].match_start_idx, results[i].match_end_idx);
+				} else {
+					printf("No match.\n\n");
+				}
+			}
+
+			destroy_regex(tester);
+
+			return;
+
+		case 84:
+			printf("Testing regex sets\n");
+
+			//A whole bunch of rules that we want to check at once
+			char* rules[] = {"abcd", "$+.txt", "([a-zA-Z]+)(@|_)([a-zA-Z]+).(com|edu)", "[0-9]+", "(ab)|(cd)", "x(y|z)*w"};
+			u_int8_t matched[6];
+
+			for(u_int32_t i = 0; i < 6; i++){
+				printf("REGEX %u: '%s'\n", i, rules[i]);
+			}
+
+			regex_set_t* set = define_regex_set(rules, 6, REGEX_SILENT);
+
+			//Test a few strings
+			char* set_strings[] = {"noreply@njit.edu has sent fname.txt", "xyzyw and 12 and abcd", "nothing here"};
+
+			for(u_int32_t i = 0; i < 3; i++){
+				printf("TEST STRING: %s\n", set_strings[i]);
+
+				u_int32_t num_matched = regex_set_match(set, set_strings[i], strlen(set_strings[i]), matched);
+				printf("%u patterns matched:", num_matched);
+
+				for(u_int32_t j = 0; j < 6; j++){
+					if(matched[j] == 1){
+						printf(" %u", j);
+					}
+				}
+
+				printf("\n\n");
+			}
+
+			destroy_regex_set(set);
+
+			return;
+
+		case 85:
+			printf("Testing streaming matches across chunk boundaries\n");
+			printf("REGEX: 'a(bc)+'\n");
+
+			tester = define_regular_expression("a(bc)+", REGEX_SILENT);
+
+			//The matches here get split up by the chunks
+			char* chunks[] = {"xxab", "cbc", "b", "cyyabcb", "c"};
+			printf("TEST CHUNKS: 'xxab' 'cbc' 'b' 'cyyabcb' 'c'\n\n");
+
+			regex_stream_t stream;
+			times_called = 0;
+			regex_stream_init(&stream, tester, print_match_callback, &times_called);
+
+			for(u_int32_t i = 0; i < 5; i++){
+				regex_stream_feed(&stream, chunks[i], strlen(chunks[i]));
+			}
+
+			//The last match runs right up to the end, so we only see it once we finish
+			regex_stream_finish(&stream);
+			printf("Callback was called %u times\n\n", times_called);
+
+			destroy_regex(tester);
+
+			//Regexes that only simulate their NFA have no DFA to stream with, and the stream says so
+			tester = define_regular_expression_flags("a(bc)+", REGEX_SILENT, REGEX_NFA);
+
+			if(regex_stream_init(&stream, tester, print_match_callback, &times_called) == REGEX_ERR){
+				printf("A REGEX_NFA regex could not be streamed\n\n");
+			}
+
+			regex_stream_finish(&stream);
+			destroy_regex(tester);
+
+			return;
+
+		case 86:
+			printf("Testing literal prefix skipping\n");
+			printf("REGEX: 'abc(d|e)+'\n");
+
+			tester = define_regular_expression("abc(d|e)+", REGEX_VERBOSE);
+
+			//A long stretch with nothing in it before the match
+			test_string = "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzabzzabcdedz";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			regex_match(tester, &matcher, test_string, 0, REGEX_VERBOSE);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			//The same thing, but length delimited. The prefix shows up twice before a real match
+			test_string = "abcxxxxxxxxxxxxxxxxxxxxxabcxxxxxxxxxxxxxxxabcee";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			regex_match_n(tester, &matcher, test_string, strlen(test_string), 0, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			destroy_regex(tester);
+
+			return;
+
+		case 87:
+			printf("Testing start byte skipping\n");
+			printf("REGEX: '[0-9]+(x|y)'\n");
+
+			tester = define_regular_expression("[0-9]+(x|y)", REGEX_VERBOSE);
+
+			//A long stretch with nothing that can start a match in it
+			test_string = "there are no digits in here for quite some time, not until the very end 12 or 345y";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			regex_match_n(tester, &matcher, test_string, strlen(test_string), 0, REGEX_VERBOSE);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			//Now with the null terminated version
+			regex_match(tester, &matcher, test_string, 0, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			destroy_regex(tester);
+
+			return;
+
+		case 88:
+			printf("Testing required factors\n");
+			printf("REGEX: '([a-zA-Z]+)(@|_)([a-zA-Z]+).(com|edu)'\n");
+
+			tester = define_regular_expression("([a-zA-Z]+)(@|_)([a-zA-Z]+).(com|edu)", REGEX_VERBOSE);
+
+			//Every match needs a ".com" or a ".edu", and these have neither
+			char* no_factor_strings[] = {"jack@robbins", "jack_robbins.org", "Jackrobbins.co"};
+			//These do
+			char* factor_strings[] = {"email jack@robbins.edu please", "jack@robbins.com", "robbins.com but no user"};
+
+			for(u_int8_t j = 0; j < 3; j++){
+				printf("TEST STRING: %s\n", no_factor_strings[j]);
+				regex_match_n(tester, &matcher, no_factor_strings[j], strlen(no_factor_strings[j]), 0, REGEX_SILENT);
+
+				//Display if we've found a match
+				if(matcher.status == MATCH_FOUND){
+					printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				} else {
+					printf("No match.\n\n");
+				}
+			}
+
+			for(u_int8_t j = 0; j < 3; j++){
+				printf("TEST STRING: %s\n", factor_strings[j]);
+				regex_match(tester, &matcher, factor_strings[j], 0, REGEX_SILENT);
+
+				//Display if we've found a match
+				if(matcher.status == MATCH_FOUND){
+					printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				} else {
+					printf("No match.\n\n");
+				}
+			}
+
+			destroy_regex(tester);
+
+			return;
+
+		case 89:
+			printf("Testing anchors and full matches\n");
+			printf("REGEX: '[0-9][0-9][0-9][0-9]-[0-9][0-9]-[0-9][0-9]'\n");
+
+			tester = define_regular_expression("[0-9][0-9][0-9][0-9]-[0-9][0-9]-[0-9][0-9]", REGEX_VERBOSE);
+
+			//Only the first one is a date all the way through
+			char* date_strings[] = {"2024-01-15", "2024-01-15x", "x2024-01-15", "2024-0l-15"};
+
+			for(u_int8_t j = 0; j < 4; j++){
+				printf("TEST STRING: %s\n", date_strings[j]);
+				regex_fullmatch(tester, &matcher, date_strings[j], strlen(date_strings[j]), REGEX_VERBOSE);
+
+				//Display if we've found a match
+				if(matcher.status == MATCH_FOUND){
+					printf("Full match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				} else {
+					printf("No full match.\n\n");
+				}
+			}
+
+			destroy_regex(tester);
+
+			printf("REGEX: '^(ab)+'\n");
+			tester = define_regular_expression("^(ab)+", REGEX_VERBOSE);
+
+			//Only the first one starts with a match
+			char* anchored_strings[] = {"ababx", "xabab"};
+
+			for(u_int8_t j = 0; j < 2; j++){
+				printf("TEST STRING: %s\n", anchored_strings[j]);
+				regex_match(tester, &matcher, anchored_strings[j], 0, REGEX_VERBOSE);
+
+				//Display if we've found a match
+				if(matcher.status == MATCH_FOUND){
+					printf("Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+				} else {
+					printf("No match.\n\n");
+				}
+			}
+
+			destroy_regex(tester);
+
+			return;
+
+		case 90:
+			printf("Testing earliest and leftmost-longest matches\n");
+			printf("REGEX: 'ab(c|d)*'\n");
+
+			//The same pattern compiled both ways
+			tester = define_regular_expression("ab(c|d)*", REGEX_VERBOSE);
+			regex_t* earliest = define_regular_expression_flags("ab(c|d)*", REGEX_VERBOSE, REGEX_EARLIEST);
+
+			test_string = "xxabcdcdxxabd";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			//Leftmost-longest keeps going for as long as it can
+			regex_match_n(tester, &matcher, test_string, strlen(test_string), 0, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Leftmost-longest match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			//Earliest stops as soon as anything matches
+			regex_match_n(earliest, &matcher, test_string, strlen(test_string), 0, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Earliest match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			destroy_regex(tester);
+			destroy_regex(earliest);
+
+			return;
+
+		case 91:
+			printf("Testing match starts found by the reverse DFA\n");
+			printf("REGEX: 'a*ab|bc'\n");
+
+			tester = define_regular_expression("a*ab|bc", REGEX_VERBOSE);
+
+			//The match starts as far back as the run of a's goes
+			test_string = "xxaaaabc";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			regex_match_n(tester, &matcher, test_string, strlen(test_string), 0, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match found! Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			//The reverse DFA must stop at the starting index, even though the a's keep going before it
+			regex_match_n(tester, &matcher, test_string, strlen(test_string), 4, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match found! Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			destroy_regex(tester);
+
+			return;
+
+		case 92:
+			printf("Testing streaming matches with overlapping prefixes\n");
+			printf("REGEX: 'aab'\n");
+
+			tester = define_regular_expression("aab", REGEX_SILENT);
+
+			//The first a can't start the match, but the second one can. A stream that went back to the start after the
+			//third a would never see this match
+			char* overlapping_chunks[] = {"xaa", "a", "by"};
+			printf("TEST CHUNKS: 'xaa' 'a' 'by'\n\n");
+
+			regex_stream_t overlapping_stream;
+			times_called = 0;
+			regex_stream_init(&overlapping_stream, tester, print_match_callback, &times_called);
+
+			for(u_int32_t i = 0; i < 3; i++){
+				regex_stream_feed(&overlapping_stream, overlapping_chunks[i], strlen(overlapping_chunks[i]));
+			}
+
+			regex_stream_finish(&overlapping_stream);
+			printf("Callback was called %u times\n\n", times_called);
+
+			destroy_regex(tester);
+
+			return;
+
+		case 93:
+			printf("Testing parallel matching on a large buffer\n");
+			printf("REGEX: '[0-9]+@[a-z]+.com'\n");
+
+			tester = define_regular_expression("[0-9]+@[a-z]+.com", REGEX_SILENT);
+
+			//Make a buffer big enough that every thread gets a chunk, and hide the match in the last one
+			size_t large_length = 4 * PARALLEL_MIN_CHUNK;
+			char* large_buffer = malloc(large_length);
+			for(size_t i = 0; i < large_length; i++){
+				large_buffer[i] = "abc 12@x"[i % 8];
+			}
+
+			memcpy(large_buffer + large_length - 20, "42@robbins.com", 14);
+			printf("TEST STRING: %zu bytes with 42@robbins.com near the end\n\n", large_length);
+
+			regex_match_parallel(tester, &matcher, large_buffer, large_length, 4, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match found! Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			//This has to be the exact same match that one thread finds
+			regex_match_n(tester, &matcher, large_buffer, large_length, 0, REGEX_SILENT);
+
+			//Display if we've found a match
+			if(matcher.status == MATCH_FOUND){
+				printf("Match found! Match starts at index: %zu and ends at index:%zu\n\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n\n");
+			}
+
+			free(large_buffer);
+			destroy_regex(tester);
+
+			return;
+
+		case 94:
+			printf("Testing boolean matches and match counts\n");
+			printf("REGEX: '[0-9]+(a|b)'\n");
+
+			tester = define_regular_expression("[0-9]+(a|b)", REGEX_SILENT);
+
+			test_string = "12a x 7b yy 300c 4a";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			//We only want to know if there's anything here
+			if(regex_is_match(tester, test_string, strlen(test_string)) == MATCH_FOUND){
+				printf("Match found!\n");
+			} else {
+				printf("No match.\n");
+			}
+
+			//This has to agree with regex_find_all
+			printf("Counted %zu matches\n", regex_count(tester, test_string, strlen(test_string)));
+			printf("Found %zu matches\n\n", regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called));
+
+			test_string = "no digits here";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			if(regex_is_match(tester, test_string, strlen(test_string)) == MATCH_FOUND){
+				printf("Match found!\n");
+			} else {
+				printf("No match.\n");
+			}
+
+			printf("Counted %zu matches\n\n", regex_count(tester, test_string, strlen(test_string)));
+
+			destroy_regex(tester);
+
+			return;
+
+		case 95:
+			printf("Testing lazily built DFAs\n");
+			printf("REGEX: 'a$$$$$$$$$$$$$$$z' with REGEX_LAZY\n");
+
+			//This DFA is far too big to build up front, so it has to be built lazily
+			tester = define_regular_expression_flags("a$$$$$$$$$$$$$$$z", REGEX_SILENT, REGEX_LAZY);
+
+			test_string = "xx abcdefghijklmnopz abcdefghijklmnopqz aaaaaaaaaaaaaaaaz";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			printf("Found %zu matches\n\n", regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called));
+
+			destroy_regex(tester);
+
+			printf("REGEX: 'a$$$$$$$$$$$$$$$z'\n");
+
+			//Without REGEX_LAZY, it's never made lazy behind our backs. It simulates the NFA instead, and has to find the same matches
+			tester = define_regular_expression("a$$$$$$$$$$$$$$$z", REGEX_SILENT);
+
+			if((tester->flags & REGEX_NFA) != 0){
+				printf("Simulating the NFA\n");
+			} else {
+				printf("Not simulating the NFA\n");
+			}
+
+			printf("Found %zu matches\n\n", regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called));
+
+			destroy_regex(tester);
+
+			printf("REGEX: '[0-9]+(a|b)' with REGEX_LAZY\n");
+
+			//Small regexes can be asked to be lazy too, and have to give the same answers
+			tester = define_regular_expression_flags("[0-9]+(a|b)", REGEX_SILENT, REGEX_LAZY);
+
+			test_string = "12a x 7b yy 300c 4a";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			printf("Counted %zu matches\n", regex_count(tester, test_string, strlen(test_string)));
+			printf("Found %zu matches\n\n", regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called));
+
+			destroy_regex(tester);
+
+			return;
+
+		case 96:
+			printf("Testing matches found by simulating the NFA\n");
+			printf("REGEX: '[0-9]+(a|b)' with REGEX_NFA\n");
+
+			//No DFAs are built for this one at all
+			tester = define_regular_expression_flags("[0-9]+(a|b)", REGEX_SILENT, REGEX_NFA);
+
+			test_string = "12a x 7b yy 300c 4a";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			//These have to agree with the DFAs
+			printf("Counted %zu matches\n", regex_count(tester, test_string, strlen(test_string)));
+			printf("Found %zu matches\n\n", regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called));
+
+			destroy_regex(tester);
+
+			printf("REGEX: '^ab(c|d)*' with REGEX_NFA\n");
+
+			tester = define_regular_expression_flags("^ab(c|d)*", REGEX_SILENT, REGEX_NFA);
+
+			test_string = "abcdcdx";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			regex_match(tester, &matcher, test_string, 0, REGEX_SILENT);
+
+			if(matcher.status == MATCH_FOUND){
+				printf("Match starts at index: %zu and ends at index: %zu\n", matcher.match_start_idx, matcher.match_end_idx);
+			} else {
+				printf("No match.\n");
+			}
+
+			//This can't be a full match because of the x
+			regex_fullmatch(tester, &matcher, test_string, strlen(test_string), REGEX_SILENT);
+			printf("Full match: %s\n\n", matcher.status == MATCH_FOUND ? "yes" : "no");
+
+			destroy_regex(tester);
+
+			return;
+
+		case 97:
+			printf("Testing the bit-parallel matcher and the Pike VM\n");
+			printf("REGEX: 'ab(c|d)*e' with REGEX_NFA\n");
+
+			//This is short enough to be matched a word at a time
+			tester = define_regular_expression_flags("ab(c|d)*e", REGEX_SILENT, REGEX_NFA);
+
+			test_string = "xxabe abcdcde abx abdde";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			printf("Found %zu matches\n\n", regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called));
+
+			destroy_regex(tester);
+
+			//This has 70 positions, which is too many to fit in a word, so it goes to the Pike VM
+			printf("REGEX: '(a|b)cdefghij' followed by 'abcdefghij' six times, with REGEX_NFA\n");
+
+			tester = define_regular_expression_flags("(a|b)cdefghijabcdefghijabcdefghijabcdefghijabcdefghijabcdefghijabcdefghij", REGEX_SILENT, REGEX_NFA);
+
+			test_string = "zzbcdefghijabcdefghijabcdefghijabcdefghijabcdefghijabcdefghijabcdefghijzz";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			printf("Found %zu matches\n\n", regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called));
+
+			destroy_regex(tester);
+
+			return;
+
+		case 98:
+			printf("Testing capture groups\n");
+			printf("REGEX: '([a-z]+)@([a-z]+)\\.(com|edu)( at work)?'\n");
+
+			tester = define_regular_expression("([a-z]+)@([a-z]+)\\.(com|edu)( at work)?", REGEX_SILENT);
+
+			test_string = "Email jack@robbins.com for details";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			regex_captures_t captures;
+			regex_match_captures(tester, &captures, test_string, strlen(test_string), 0, REGEX_SILENT);
+
+			if(captures.status == MATCH_FOUND){
+				for(u_int32_t j = 0; j <= captures.num_groups; j++){
+					if(captures.groups[j].start == REGEX_NO_GROUP){
+						printf("Group %u did not match\n", j);
+					} else {
+						printf("Group %u: %.*s\n", j, (int)(captures.groups[j].end - captures.groups[j].start), test_string + captures.groups[j].start);
+					}
+				}
+			} else {
+				printf("No match found\n");
+			}
+
+			printf("\n");
+
+			destroy_regex(tester);
+
+			return;
+
+		case 99:
+			printf("Testing matching a file\n");
+			printf("REGEX: '[a-z]+@[a-z]+\\.(com|edu)'\n");
+
+			tester = define_regular_expression("[a-z]+@[a-z]+\\.(com|edu)", REGEX_SILENT);
+
+			//Write out a small file for us to search
+			char file_path[] = "/tmp/regex_file_testXXXXXX";
+			int file_descriptor = mkstemp(file_path);
+
+			if(file_descriptor < 0){
+				printf("Could not create a file to search\n\n");
+				destroy_regex(tester);
+				return;
+			}
+
+			test_string = "Write to jack@robbins.com\nor to someone@school.edu\nbut not to nobody@nowhere\n";
+			printf("FILE CONTENTS: %s\n", test_string);
+
+			if(write(file_descriptor, test_string, strlen(test_string)) < 0){
+				printf("Could not write the file to search\n\n");
+			}
+
+			close(file_descriptor);
+
+			times_called = 0;
+			printf("Found %zu matches\n", regex_match_file(tester, file_path, print_match_callback, &times_called));
+			printf("Callback was called %u times\n", times_called);
+
+			//Files that aren't there are reported as errors
+			if(regex_match_file(tester, "/tmp/regex_file_test_does_not_exist", NULL, NULL) == REGEX_FILE_ERR){
+				printf("A file that doesn't exist could not be searched\n");
+			}
+
+			printf("\n");
+
+			unlink(file_path);
+			destroy_regex(tester);
+
+			return;
+
+		case 100:
+			printf("Testing matching lines\n");
+			printf("REGEX: '[a-z]+@[a-z]+\\.(com|edu)'\n");
+
+			tester = define_regular_expression("[a-z]+@[a-z]+\\.(com|edu)", REGEX_SILENT);
+
+			test_string = "Write to jack@robbins.com\n\nor to someone@school.edu\nbut not to nobody@nowhere\nand jack@robbins.com twice jack@robbins.com\n";
+			printf("TEST STRING: %s\n", test_string);
+
+			printf("Found %zu matching lines\n\n", regex_match_lines(tester, test_string, strlen(test_string), print_line_callback, test_string));
+
+			destroy_regex(tester);
+
+			//Anchors mean the start of each line
+			printf("REGEX: '^[a-z]+ to'\n");
+
+			tester = define_regular_expression("^[a-z]+ to", REGEX_SILENT);
+
+			printf("TEST STRING: %s\n", test_string);
+
+			printf("Found %zu matching lines\n\n", regex_match_lines(tester, test_string, strlen(test_string), print_line_callback, test_string));
+
+			destroy_regex(tester);
+
+			return;
+
+		case 101:
+			printf("Testing matching many regexes in lockstep\n");
+
+			char* lockstep_patterns[] = {"[a-z]+@[a-z]+\\.com", "[0-9]+ dollars", "^Order", "refund", "(a|b)cc(a|b)"};
+			regex_t* lockstep_regexes[5];
+			u_int8_t lockstep_matched[5];
+
+			for(u_int32_t j = 0; j < 5; j++){
+				lockstep_regexes[j] = define_regular_expression(lockstep_patterns[j], REGEX_SILENT);
+			}
+
+			test_string = "Order 5521 for 45 dollars, contact jack@robbins.com";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			printf("%u regexes matched\n", regex_match_lockstep(lockstep_regexes, 5, test_string, strlen(test_string), lockstep_matched));
+
+			for(u_int32_t j = 0; j < 5; j++){
+				printf("REGEX: '%s' %s\n", lockstep_patterns[j], lockstep_matched[j] == 1 ? "matched" : "did not match");
+				destroy_regex(lockstep_regexes[j]);
+			}
+
+			printf("\n");
+
+			return;
+
+		case 102:
+			printf("Testing case insensitive matching\n");
+			printf("REGEX: 'jack@[a-z]+\\.COM' with REGEX_ICASE\n");
+
+			tester = define_regular_expression_flags("jack@[a-z]+\\.COM", REGEX_SILENT, REGEX_ICASE);
+
+			test_string = "Contact JACK@Robbins.com or jack@ROBBINS.COM or jake@robbins.com";
+			printf("TEST STRING: %s\n\n", test_string);
+
+			times_called = 0;
+			printf("Found %zu matches\n\n", regex_find_all(tester, test_string, strlen(test_string), NULL, 0, print_match_callback, &times_called));
+
+			destroy_regex(tester);
+
+			return;
+
+		case 103:
+			printf("Testing anchored patterns in a regex set\n");
+
+			char* set_anchor_patterns[] = {"^ab", "^ab|x", "b(c|d)", "^$*z"};
+			char* set_anchor_strings[] = {"abx", "zzx", "xbd", "qz", "zab"};
+			regex_t* set_anchor_regexes[4];
+			u_int8_t set_anchor_matched[4];
+
+			regex_set_t* set_anchor_set = define_regex_set(set_anchor_patterns, 4, REGEX_SILENT);
+
+			for(u_int32_t j = 0; j < 4; j++){
+				set_anchor_regexes[j] = define_regular_expression(set_anchor_patterns[j], REGEX_SILENT);
+			}
+
+			//The set has to agree with every regex on its own
+			for(u_int32_t j = 0; j < 5; j++){
+				printf("TEST STRING: %s\n", set_anchor_strings[j]);
+				regex_set_match(set_anchor_set, set_anchor_strings[j], strlen(set_anchor_strings[j]), set_anchor_matched);
+
+				for(u_int32_t k = 0; k < 4; k++){
+					match_status_t single = regex_is_match(set_anchor_regexes[k], set_anchor_strings[j], strlen(set_anchor_strings[j]));
+
+					printf("REGEX: '%s' set: %s single: %s%s\n", set_anchor_patterns[k], set_anchor_matched[k] == 1 ? "matched" : "no match",
+						single == MATCH_FOUND ? "matched" : "no match", (set_anchor_matched[k] == 1) == (single == MATCH_FOUND) ? "" : " MISMATCH");
+				}
+
+				printf("\n");
+			}
+
+			for(u_int32_t j = 0; j < 4; j++){
+				destroy_regex(set_anchor_regexes[j]);
+			}
+
+			destroy_regex_set(set_anchor_set);
+
+			return;
+
+		case 104:
+			printf("Testing loading whole files\n");
+			printf("REGEX: '[a-z]+@[a-z]+\\.(com|edu)'\n");
+
+			tester = define_regular_expression("[a-z]+@[a-z]+\\.(com|edu)", REGEX_SILENT);
+
+			char load_path[] = "/tmp/regex_load_testXXXXXX";
+			int load_descriptor = mkstemp(load_path);
+			regex_file_t loaded;
+
+			if(load_descriptor < 0){
+				printf("Could not create a file to load\n\n");
+				destroy_regex(tester);
+				return;
+			}
+
+			test_string = "Write to jack@robbins.com\nor to someone@school.edu\nbut not to nobody@nowhere\n";
+			printf("FILE CONTENTS: %s\n", test_string);
+
+			if(write(load_descriptor, test_string, strlen(test_string)) < 0){
+				printf("Could not write the file to load\n\n");
+			}
+
+			//Small files are read in from wherever the file is at, so we have to go back to the start
+			lseek(load_descriptor, 0, SEEK_SET);
+
+			if(regex_load_file(&loaded, load_descriptor) != NULL){
+				printf("Loaded %zu bytes, mapped: %u\n", loaded.length, loaded.mapped);
+				printf("Found %zu matching lines\n\n", regex_match_lines(tester, loaded.buffer, loaded.length, NULL, NULL));
+				regex_unload_file(&loaded);
+			}
+
+			//Pad the file out until it's big enough to be mapped in instead
+			for(u_int32_t j = 0; j < FILE_MMAP_MIN_SIZE / 32; j++){
+				if(write(load_descriptor, "nothing to see on this line....\n", 32) < 0){
+					printf("Could not write the file to load\n\n");
+					break;
+				}
+			}
+
+			if(write(load_descriptor, "last@line.edu\n", 14) < 0){
+				printf("Could not write the file to load\n\n");
+			}
+
+			if(regex_load_file(&loaded, load_descriptor) != NULL){
+				printf("Loaded %zu bytes, mapped: %u\n", loaded.length, loaded.mapped);
+				printf("Found %zu matching lines\n\n", regex_match_lines(tester, loaded.buffer, loaded.length, NULL, NULL));
+				regex_unload_file(&loaded);
+			}
+
+			close(load_descriptor);
+			unlink(load_path);
+
+			//Files that can't be read are reported as errors
+			if(regex_load_file(&loaded, -1) == NULL){
+				printf("A bad file descriptor could not be loaded\n");
+			}
+
+			destroy_regex(tester);
+
+			return;
+
 		//Added to avoid comptime errors, we shouldn't reach this
 		default:
 			return;
@@ -2264,7 +3138,7 @@ int main(int argc, char** argv){
 	//Run them all
 	if(argc == 1){
 		begin = clock();
-		for(u_int8_t i = 0; i < 80; i++){
+		for(u_int8_t i = 0; i < 105; i++){
 			test_case_run(i);
 		}
 		end = clock();
@@ -0,0 +1,416 @@
+/**
+ * Author: Jack Robbins
+ * rgx is a small grep built on the regex library. It prints every line of its input that has a match in it, and can
+ * count the matching lines, list the files that match, or number the lines instead. Big files are mapped into memory and
+ * searched in place, and when more than one file is given, they are searched at the same time by a pool of worker threads.
+ * The output always comes out in the same order as the files were given
+ *
+ * Usage: rgx [-c] [-l] [-n] [-i] [-j threads] pattern [file...]
+ */
+
+#include "regex/regex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+//The most worker threads that we'll search files with
+#define RGX_MAX_THREADS 64
+
+
+/**
+ * What the user asked us to print
+ */
+typedef enum {
+	RGX_LINES,
+	RGX_COUNT,
+	RGX_FILES_WITH_MATCHES
+} rgx_output_t;
+
+
+/**
+ * Everything that the command line told us to do
+ */
+typedef struct {
+	char* pattern;
+	//The flags that the pattern is compiled with
+	u_int32_t flags;
+	rgx_output_t output;
+	//Print the line number in front of every line
+	u_int8_t line_numbers;
+	//Print the file name in front of every line, which we do whenever there's more than one file
+	u_int8_t file_names;
+} rgx_options_t;
+
+
+/**
+ * One file that we're searching. The worker that searches it writes everything that it would print into "output", and the
+ * main thread prints it once "done" is set, so that the output comes out in order
+ */
+typedef struct {
+	char* path;
+	char* output;
+	size_t output_length;
+	//How many lines matched, or REGEX_FILE_ERR if the file couldn't be read
+	size_t num_matched;
+	u_int8_t done;
+} rgx_file_t;
+
+
+/**
+ * What the line callback needs to print a line
+ */
+typedef struct {
+	rgx_options_t* options;
+	const char* path;
+	const char* buffer;
+	FILE* out;
+} rgx_printer_t;
+
+
+/**
+ * Shared between the main thread and every worker. Workers take the next file off of the list until there are none left
+ */
+typedef struct {
+	rgx_options_t* options;
+	//Never compiled with REGEX_LAZY, so every worker can search it at once
+	regex_t* regex;
+	rgx_file_t* files;
+	u_int32_t num_files;
+	u_int32_t next_file;
+	pthread_mutex_t lock;
+	pthread_cond_t file_done;
+} rgx_pool_t;
+
+
+/**
+ * Print out how to use rgx
+ */
+static void usage(){
+	fprintf(stderr, "Usage: rgx [-c] [-l] [-n] [-i] [-j threads] pattern [file...]\n");
+	fprintf(stderr, "\t-c\tPrint how many lines matched instead of the lines\n");
+	fprintf(stderr, "\t-l\tPrint only the names of files that have a match\n");
+	fprintf(stderr, "\t-n\tPrint the line number in front of every line\n");
+	fprintf(stderr, "\t-i\tIgnore case when matching letters\n");
+	fprintf(stderr, "\t-j\tSearch up to this many files at once\n");
+	fprintf(stderr, "With no files, or a file of -, standard input is searched\n");
+}
+
+
+/**
+ * Print out one matching line, along with whatever needs to go in front of it
+ */
+static int print_line(regex_line_t* line, void* user_data){
+	rgx_printer_t* printer = (rgx_printer_t*)user_data;
+
+	if(printer->options->file_names == 1){
+		fprintf(printer->out, "%s:", printer->path);
+	}
+
+	if(printer->options->line_numbers == 1){
+		fprintf(printer->out, "%zu:", line->line_number);
+	}
+
+	fwrite(printer->buffer + line->line_start, 1, line->line_end - line->line_start, printer->out);
+	fputc('\n', printer->out);
+
+	//Keep going
+	return 0;
+}
+
+
+/**
+ * For files-with-matches, the first matching line is all that we need to see
+ */
+static int stop_at_first_line(regex_line_t* line, void* user_data){
+	(void)line;
+	(void)user_data;
+	return 1;
+}
+
+
+/**
+ * Search one file, printing whatever the options ask for into "out". The library loads it for us, mapping big regular files into
+ * memory and reading everything else in. Returns how many lines matched, or REGEX_FILE_ERR if the file couldn't be read
+ */
+static size_t search_file(regex_t* regex, rgx_options_t* options, const char* path, FILE* out){
+	rgx_printer_t printer;
+	regex_file_t file;
+	size_t num_matched;
+	int file_descriptor;
+
+	//A path of - means standard input
+	if(strcmp(path, "-") == 0){
+		file_descriptor = STDIN_FILENO;
+		path = "(standard input)";
+	} else {
+		file_descriptor = open(path, O_RDONLY);
+	}
+
+	if(file_descriptor < 0 || regex_load_file(&file, file_descriptor) == NULL){
+		fprintf(stderr, "rgx: %s: %s\n", path, strerror(errno));
+
+		if(file_descriptor > STDIN_FILENO){
+			close(file_descriptor);
+		}
+
+		return REGEX_FILE_ERR;
+	}
+
+	//A mapped file stays mapped after it's closed
+	if(file_descriptor > STDIN_FILENO){
+		close(file_descriptor);
+	}
+
+	printer.options = options;
+	printer.path = path;
+	printer.buffer = file.buffer;
+	printer.out = out;
+
+	switch(options->output){
+		case RGX_COUNT:
+			num_matched = regex_match_lines(regex, file.buffer, file.length, NULL, NULL);
+
+			if(options->file_names == 1){
+				fprintf(out, "%s:", path);
+			}
+
+			fprintf(out, "%zu\n", num_matched);
+			break;
+
+		case RGX_FILES_WITH_MATCHES:
+			num_matched = regex_match_lines(regex, file.buffer, file.length, stop_at_first_line, NULL);
+
+			if(num_matched > 0){
+				fprintf(out, "%s\n", path);
+			}
+
+			break;
+
+		default:
+			num_matched = regex_match_lines(regex, file.buffer, file.length, print_line, &printer);
+			break;
+	}
+
+	regex_unload_file(&file);
+
+	return num_matched;
+}
+
+
+/**
+ * A worker thread. It takes files off of the list one at a time, writing each one's output into memory for the main thread to print
+ */
+static void* search_worker(void* argument){
+	rgx_pool_t* pool = (rgx_pool_t*)argument;
+	rgx_file_t* file;
+	FILE* out;
+
+	while(1){
+		pthread_mutex_lock(&(pool->lock));
+
+		//If every file has been taken, we're done
+		if(pool->next_file == pool->num_files){
+			pthread_mutex_unlock(&(pool->lock));
+			break;
+		}
+
+		file = &(pool->files[pool->next_file]);
+		pool->next_file++;
+
+		pthread_mutex_unlock(&(pool->lock));
+
+		out = open_memstream(&(file->output), &(file->output_length));
+
+		//If we have nowhere to put the output, this file can't be searched
+		if(out == NULL){
+			fprintf(stderr, "rgx: %s: %s\n", file->path, strerror(errno));
+			file->num_matched = REGEX_FILE_ERR;
+		} else {
+			file->num_matched = search_file(pool->regex, pool->options, file->path, out);
+			fclose(out);
+		}
+
+		//Let the main thread know that this one can be printed
+		pthread_mutex_lock(&(pool->lock));
+		file->done = 1;
+		pthread_cond_broadcast(&(pool->file_done));
+		pthread_mutex_unlock(&(pool->lock));
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Search every file with a pool of workers, printing each file's output in order as soon as it and every file before it are
+ * done. Returns 0 if anything matched, 1 if nothing did and 2 if a file couldn't be read
+ */
+static int search_files(regex_t* regex, rgx_options_t* options, char** paths, u_int32_t num_files, u_int32_t num_threads){
+	pthread_t threads[RGX_MAX_THREADS];
+	u_int8_t started[RGX_MAX_THREADS];
+	u_int32_t num_started = 0;
+	rgx_pool_t pool;
+	u_int8_t matched = 0;
+	u_int8_t error = 0;
+
+	pool.options = options;
+	pool.regex = regex;
+	pool.files = calloc(num_files, sizeof(rgx_file_t));
+	pool.num_files = num_files;
+	pool.next_file = 0;
+	pthread_mutex_init(&(pool.lock), NULL);
+	pthread_cond_init(&(pool.file_done), NULL);
+
+	for(u_int32_t i = 0; i < num_files; i++){
+		pool.files[i].path = paths[i];
+	}
+
+	//There's no point in having more workers than files
+	if(num_threads > num_files){
+		num_threads = num_files;
+	}
+
+	for(u_int32_t i = 0; i < num_threads; i++){
+		started[i] = pthread_create(&(threads[i]), NULL, search_worker, &pool) == 0;
+		num_started += started[i];
+	}
+
+	//If we couldn't start a single worker, nobody would ever finish a file for us to print, so we search them all right here
+	if(num_started == 0){
+		search_worker(&pool);
+	}
+
+	//Print every file in order, waiting on it if it isn't done yet
+	for(u_int32_t i = 0; i < num_files; i++){
+		pthread_mutex_lock(&(pool.lock));
+
+		while(pool.files[i].done == 0){
+			pthread_cond_wait(&(pool.file_done), &(pool.lock));
+		}
+
+		pthread_mutex_unlock(&(pool.lock));
+
+		fwrite(pool.files[i].output, 1, pool.files[i].output_length, stdout);
+		free(pool.files[i].output);
+
+		if(pool.files[i].num_matched == REGEX_FILE_ERR){
+			error = 1;
+		} else if(pool.files[i].num_matched > 0){
+			matched = 1;
+		}
+	}
+
+	for(u_int32_t i = 0; i < num_threads; i++){
+		if(started[i] == 1){
+			pthread_join(threads[i], NULL);
+		}
+	}
+
+	pthread_mutex_destroy(&(pool.lock));
+	pthread_cond_destroy(&(pool.file_done));
+	free(pool.files);
+
+	if(error == 1){
+		return 2;
+	}
+
+	return matched == 1 ? 0 : 1;
+}
+
+
+/**
+ * Parse the command line and search everything that we were given
+ */
+int main(int argc, char** argv){
+	rgx_options_t options;
+	long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int option;
+
+	options.flags = 0;
+	options.output = RGX_LINES;
+	options.line_numbers = 0;
+	options.file_names = 0;
+
+	while((option = getopt(argc, argv, "clnij:")) != -1){
+		switch(option){
+			case 'c':
+				options.output = RGX_COUNT;
+				break;
+			case 'l':
+				options.output = RGX_FILES_WITH_MATCHES;
+				break;
+			case 'n':
+				options.line_numbers = 1;
+				break;
+			case 'i':
+				options.flags |= REGEX_ICASE;
+				break;
+			case 'j':
+				num_threads = atol(optarg);
+				break;
+			default:
+				usage();
+				return 2;
+		}
+	}
+
+	//We need a pattern at the very least
+	if(optind >= argc){
+		usage();
+		return 2;
+	}
+
+	options.pattern = argv[optind];
+	optind++;
+
+	//Keep the number of workers sane
+	if(num_threads < 1){
+		num_threads = 1;
+	} else if(num_threads > RGX_MAX_THREADS){
+		num_threads = RGX_MAX_THREADS;
+	}
+
+	regex_t* regex = define_regular_expression_flags(options.pattern, REGEX_SILENT, options.flags);
+
+	if(regex->state != REGEX_VALID){
+		fprintf(stderr, "rgx: invalid pattern: %s\n", options.pattern);
+		destroy_regex(regex);
+		return 2;
+	}
+
+	//With no files, we search standard input
+	if(optind == argc){
+		size_t num_matched = search_file(regex, &options, "-", stdout);
+		destroy_regex(regex);
+
+		if(num_matched == REGEX_FILE_ERR){
+			return 2;
+		}
+
+		return num_matched > 0 ? 0 : 1;
+	}
+
+	//With one file, there's nothing to do at the same time
+	if(optind == argc - 1){
+		size_t num_matched = search_file(regex, &options, argv[optind], stdout);
+		destroy_regex(regex);
+
+		if(num_matched == REGEX_FILE_ERR){
+			return 2;
+		}
+
+		return num_matched > 0 ? 0 : 1;
+	}
+
+	options.file_names = 1;
+
+	int status = search_files(regex, &options, argv + optind, argc - optind, num_threads);
+	destroy_regex(regex);
+
+	return status;
+}